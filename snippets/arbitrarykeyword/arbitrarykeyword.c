@@ -13,6 +13,8 @@
 #include "py/objlist.h"
 #include "py/runtime.h"
 #include "py/builtin.h"
+#include "record.h"
+#include "instrument.h"
 
 // This is lifted from objfloat.c, because mp_obj_float_t is not exposed there (there is no header file)
 typedef struct _mp_obj_float_t {
@@ -32,6 +34,10 @@ const mp_rom_obj_tuple_t my_tuple = {
     },
 };
 
+// The arguments are returned as a record, whose fields can be read by name, or unpacked as a tuple
+STATIC const qstr arbitrarykeyword_fields[] = { MP_QSTR_a, MP_QSTR_b, MP_QSTR_c, MP_QSTR_d, MP_QSTR_e };
+STATIC const record_type_t arbitrarykeyword_type = RECORD_TYPE(MP_QSTR_arguments, arbitrarykeyword_fields);
+
 STATIC mp_obj_t arbitrarykeyword_print(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
     static const mp_arg_t allowed_args[] = {
         { MP_QSTR_a, MP_ARG_INT, {.u_int = 0} },
@@ -43,16 +49,17 @@ STATIC mp_obj_t arbitrarykeyword_print(size_t n_args, const mp_obj_t *pos_args,
 
     mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
     mp_arg_parse_all(1, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
-    mp_obj_t tuple[5];
-    tuple[0] = mp_obj_new_int(args[0].u_int); // a
-    tuple[1] = mp_obj_new_int(args[1].u_int); // b
-    tuple[2] = args[2].u_obj; // c
-    tuple[3] = args[3].u_obj; // d
-    tuple[4] = args[4].u_obj; // e
-    return mp_obj_new_tuple(5, tuple);
+    mp_obj_t items[5];
+    items[0] = mp_obj_new_int(args[0].u_int); // a
+    items[1] = mp_obj_new_int(args[1].u_int); // b
+    items[2] = args[2].u_obj; // c
+    items[3] = args[3].u_obj; // d
+    items[4] = args[4].u_obj; // e
+    return record_new(&arbitrarykeyword_type, items);
 }
 
-STATIC MP_DEFINE_CONST_FUN_OBJ_KW(arbitrarykeyword_print_obj, 1, arbitrarykeyword_print);
+INSTRUMENT_WRAP_KW(arbitrarykeyword_print)
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(arbitrarykeyword_print_obj, 1, INSTRUMENT(arbitrarykeyword_print));
 
 STATIC const mp_rom_map_elem_t arbitrarykeyword_module_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_arbitrarykeyword) },
@@ -0,0 +1,71 @@
+/*
+ * This file is part of the micropython-usermod project, 
+ *
+ * https://github.com/v923z/micropython-usermod
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020 Zoltán Vörös
+*/
+    
+#ifndef _BYTEORDER_H_
+#define _BYTEORDER_H_
+
+#include <string.h>
+#include "py/obj.h"
+#include "py/runtime.h"
+#include "py/binary.h"
+
+// Helpers of the to_bytes, from_bytes, and pack_into methods, shared by vector, specialclass,
+// sliceiterable, and subscriptiterable
+
+// Returns true for 'big', and false for 'little'; anything else raises ValueError
+static inline bool byteorder_big_endian(mp_obj_t byteorder) {
+    const char *order = mp_obj_str_get_str(byteorder);
+    if(strcmp(order, "big") == 0) {
+        return true;
+    } else if(strcmp(order, "little") != 0) {
+        mp_raise_ValueError("byteorder must be either 'little' or 'big'");
+    }
+    return false;
+}
+
+// Returns a pointer to nbytes in the buffer starting at offset, or raises ValueError, if they are not there
+static inline byte *byteorder_buffer_at(mp_obj_t buffer, mp_int_t offset, size_t nbytes, mp_uint_t flags) {
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(buffer, &bufinfo, flags);
+    if((offset < 0) || ((size_t)offset > bufinfo.len) || (bufinfo.len - offset < nbytes)) {
+        mp_raise_ValueError("buffer is too small");
+    }
+    return (byte *)bufinfo.buf + offset;
+}
+
+// Writes len 16-bit integers in the requested byte order; dest need not be aligned
+static inline void byteorder_store_uint16(byte *dest, const uint16_t *src, size_t len, bool big_endian) {
+    if(len == 0) { // an empty array need not have any memory, and memcpy must not be passed NULL
+        return;
+    }
+    if(big_endian == MP_ENDIANNESS_BIG) {
+        memcpy(dest, src, len * sizeof(uint16_t));
+    } else {
+        for(size_t i=0; i < len; i++) {
+            mp_binary_set_int(sizeof(uint16_t), big_endian, dest + i * sizeof(uint16_t), src[i]);
+        }
+    }
+}
+
+// Reads len 16-bit integers in the requested byte order; src need not be aligned
+static inline void byteorder_load_uint16(uint16_t *dest, const byte *src, size_t len, bool big_endian) {
+    if(len == 0) {
+        return;
+    }
+    if(big_endian == MP_ENDIANNESS_BIG) {
+        memcpy(dest, src, len * sizeof(uint16_t));
+    } else {
+        for(size_t i=0; i < len; i++) {
+            dest[i] = mp_binary_get_int(sizeof(uint16_t), false, big_endian, src + i * sizeof(uint16_t));
+        }
+    }
+}
+
+#endif
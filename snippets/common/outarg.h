@@ -0,0 +1,48 @@
+/*
+ * This file is part of the micropython-usermod project, 
+ *
+ * https://github.com/v923z/micropython-usermod
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020 Zoltán Vörös
+*/
+    
+#ifndef _OUTARG_H_
+#define _OUTARG_H_
+
+#include "py/obj.h"
+#include "py/runtime.h"
+#include "py/binary.h"
+
+// The out= convention: instead of returning a new float object, or a tuple of them, a kernel
+// writes its results into out[index:index+n], where out is an array of type 'f', or 'd', and
+// returns out itself, so that nothing is allocated.
+
+static inline void outarg_store_floats(mp_obj_t out, mp_int_t index, const mp_float_t *values, size_t n) {
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(out, &bufinfo, MP_BUFFER_WRITE);
+    size_t len = bufinfo.len / mp_binary_get_size('@', bufinfo.typecode, NULL);
+    if((index < 0) || ((size_t)index + n > len)) {
+        mp_raise_msg(&mp_type_IndexError, "index out of range");
+    }
+    if(bufinfo.typecode == 'f') {
+        float *dest = (float *)bufinfo.buf + index;
+        for(size_t i=0; i < n; i++) {
+            dest[i] = (float)values[i];
+        }
+    } else if(bufinfo.typecode == 'd') {
+        double *dest = (double *)bufinfo.buf + index;
+        for(size_t i=0; i < n; i++) {
+            dest[i] = (double)values[i];
+        }
+    } else {
+        mp_raise_TypeError("out must be an array of type 'f', or 'd'");
+    }
+}
+
+static inline void outarg_store_float(mp_obj_t out, mp_int_t index, mp_float_t value) {
+    outarg_store_floats(out, index, &value, 1);
+}
+
+#endif
@@ -0,0 +1,44 @@
+/*
+ * This file is part of the micropython-usermod project, 
+ *
+ * https://github.com/v923z/micropython-usermod
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020 Zoltán Vörös
+*/
+    
+#ifndef _PAUSE_H_
+#define _PAUSE_H_
+
+#include "py/obj.h"
+#include "py/runtime.h"
+
+// The objects returned by the *_async functions are their own iterators, so that they can be
+// awaited in a uasyncio task. Each call of iternext does one chunk of the work, and then hands
+// control back to the scheduler with what pause_yield returns.
+
+// Returns uasyncio.sleep_ms, or MP_OBJ_NULL, if it cannot be imported
+static inline mp_obj_t pause_get(void) {
+    mp_obj_t pause = MP_OBJ_NULL;
+    nlr_buf_t nlr;
+    if(nlr_push(&nlr) == 0) {
+        mp_obj_t uasyncio = mp_import_name(MP_QSTR_uasyncio, mp_const_none, MP_OBJ_NEW_SMALL_INT(0));
+        pause = mp_load_attr(uasyncio, MP_QSTR_sleep_ms);
+        nlr_pop();
+    }
+    return pause;
+}
+
+// Returns the value that iternext yields at the end of a chunk; pause is what pause_get returned
+static inline mp_obj_t pause_yield(mp_obj_t pause) {
+    if(pause == MP_OBJ_NULL) {
+        // a bare yield, the scheduler is expected to resume the task
+        return mp_const_none;
+    }
+    // sleep_ms(0) puts the current task back into the queue of uasyncio, and what it yields, is passed on
+    mp_obj_t yielded = mp_iternext(mp_call_function_1(pause, MP_OBJ_NEW_SMALL_INT(0)));
+    return yielded == MP_OBJ_STOP_ITERATION ? mp_const_none : yielded;
+}
+
+#endif
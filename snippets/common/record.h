@@ -0,0 +1,103 @@
+/*
+ * This file is part of the micropython-usermod project, 
+ *
+ * https://github.com/v923z/micropython-usermod
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020 Zoltán Vörös
+*/
+    
+#ifndef _RECORD_H_
+#define _RECORD_H_
+
+#include "py/obj.h"
+#include "py/runtime.h"
+#include "py/objtuple.h"
+
+// A record type is a tuple type with a fixed list of field names. The records have the layout
+// of mp_obj_tuple_t, with the values stored inline after the header, so that a record costs a
+// single allocation. Indexing, len(), unpacking, hashing and comparisons are those of tuples,
+// and isinstance(record, tuple) holds. A field is read by finding its qstr in the list of
+// names, and reading the slot at the same position. Records are read-only.
+//
+// The types are defined statically with the RECORD_TYPE macro:
+//
+//     STATIC const qstr measure_fields[] = { MP_QSTR_start, MP_QSTR_middle, MP_QSTR_end };
+//     STATIC const record_type_t measure_type = RECORD_TYPE(MP_QSTR_measurement, measure_fields);
+//
+// and the records are created by record_new(&measure_type, items), where items holds one
+// value for each field. The header has no translation unit of its own: each module that uses
+// it has ../common in its include path.
+
+typedef struct _record_type_t {
+    mp_obj_type_t base;
+    size_t n_fields;
+    const qstr *fields;
+} record_type_t;
+
+// Returns the position of the field, or -1, if there is no such field. A record has only
+// a handful of fields, and qstrs are compared as integers, so the scan is cheaper than hashing.
+static inline mp_int_t record_find_field(const record_type_t *type, qstr name) {
+    for(size_t i=0; i < type->n_fields; i++) {
+        if(type->fields[i] == name) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static inline void record_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t kind) {
+    (void)kind;
+    mp_obj_tuple_t *self = MP_OBJ_TO_PTR(self_in);
+    const record_type_t *type = (const record_type_t *)self->base.type;
+    mp_printf(print, "%q(", type->base.name);
+    for(size_t i=0; i < self->len; i++) {
+        if(i > 0) {
+            mp_print_str(print, ", ");
+        }
+        mp_printf(print, "%q=", type->fields[i]);
+        mp_obj_print_helper(print, self->items[i], PRINT_REPR);
+    }
+    mp_print_str(print, ")");
+}
+
+static inline void record_attr(mp_obj_t self_in, qstr attr, mp_obj_t *dest) {
+    if(dest[0] != MP_OBJ_NULL) {
+        // the fields can't be stored, or deleted
+        return;
+    }
+    mp_obj_tuple_t *self = MP_OBJ_TO_PTR(self_in);
+    mp_int_t index = record_find_field((const record_type_t *)self->base.type, attr);
+    if(index >= 0) {
+        dest[0] = self->items[index];
+    }
+}
+
+static inline mp_obj_t record_new(const record_type_t *type, const mp_obj_t *items) {
+    mp_obj_tuple_t *record = m_new_obj_var(mp_obj_tuple_t, mp_obj_t, type->n_fields);
+    record->base.type = &type->base;
+    record->len = type->n_fields;
+    for(size_t i=0; i < type->n_fields; i++) {
+        record->items[i] = items[i];
+    }
+    return MP_OBJ_FROM_PTR(record);
+}
+
+#define RECORD_TYPE(type_name, field_names) {\
+    {\
+        { &mp_type_type },\
+        .name = (type_name),\
+        .print = record_print,\
+        .unary_op = mp_obj_tuple_unary_op,\
+        .binary_op = mp_obj_tuple_binary_op,\
+        .attr = record_attr,\
+        .subscr = mp_obj_tuple_subscr,\
+        .getiter = mp_obj_tuple_getiter,\
+        .parent = &mp_type_tuple,\
+    },\
+    MP_ARRAY_SIZE(field_names),\
+    (field_names),\
+}
+
+#endif
@@ -0,0 +1,258 @@
+/*
+ * This file is part of the micropython-usermod project, 
+ *
+ * https://github.com/v923z/micropython-usermod
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020 Zoltán Vörös
+*/
+    
+#ifndef _UINT16KERNELS_H_
+#define _UINT16KERNELS_H_
+
+#include <stdlib.h>
+#include <string.h>
+#include "py/obj.h"
+#include "py/runtime.h"
+#include "py/binary.h"
+
+// Kernels over raw uint16_t elements, shared by sliceitarray, and subitarray. They allocate
+// nothing on the python heap, only scratch memory with malloc.
+
+// The counts of the radix passes are kept in the same block as the scratch buffer, and not on
+// the stack, where they would take 4 kB on a 32-bit microcontroller
+typedef struct _uint16kernels_work_t {
+    size_t count[2][256];
+    uint16_t scratch[];
+} uint16kernels_work_t;
+
+static inline uint16_t *uint16kernels_new_scratch(size_t len) {
+    uint16_t *scratch = malloc(len * sizeof(uint16_t));
+    if(scratch == NULL) {
+        m_malloc_fail(len * sizeof(uint16_t));
+    }
+    return scratch;
+}
+
+static inline uint16kernels_work_t *uint16kernels_new_work(size_t len) {
+    size_t size = sizeof(uint16kernels_work_t) + len * sizeof(uint16_t);
+    uint16kernels_work_t *work = malloc(size);
+    if(work == NULL) {
+        m_malloc_fail(size);
+    }
+    return work;
+}
+
+// LSD radix sort, one pass per byte, with work->scratch holding at least len elements. A pass
+// is skipped, if all elements have the same value in that byte, e.g., the high byte is skipped
+// for values below 256.
+static inline void uint16kernels_radix_sort(uint16_t *arr, uint16kernels_work_t *work, size_t len) {
+    memset(work->count, 0, sizeof(work->count));
+    for(size_t i=0; i < len; i++) {
+        work->count[0][arr[i] & 0xFF]++;
+        work->count[1][arr[i] >> 8]++;
+    }
+    uint16_t *src = arr, *dest = work->scratch;
+    for(uint8_t pass=0; pass < 2; pass++) {
+        size_t *count = work->count[pass];
+        uint8_t shift = 8 * pass;
+        if(count[(arr[0] >> shift) & 0xFF] == len) {
+            continue;
+        }
+        size_t offset = 0;
+        for(size_t b=0; b < 256; b++) {
+            size_t c = count[b];
+            count[b] = offset;
+            offset += c;
+        }
+        for(size_t i=0; i < len; i++) {
+            dest[count[(src[i] >> shift) & 0xFF]++] = src[i];
+        }
+        uint16_t *tmp = src;
+        src = dest;
+        dest = tmp;
+    }
+    if(src != arr) {
+        memcpy(arr, src, len * sizeof(uint16_t));
+    }
+}
+
+// Sorts arr in place
+static inline void uint16kernels_sort(uint16_t *arr, size_t len) {
+    if(len < 2) {
+        return;
+    }
+    uint16kernels_work_t *work = uint16kernels_new_work(len);
+    uint16kernels_radix_sort(arr, work, len);
+    free(work);
+}
+
+// Stable indirect radix sort: idx receives the indices that would sort arr
+static inline void uint16kernels_argsort(const uint16_t *arr, uint16_t *idx, size_t len) {
+    if(len == 0) {
+        return;
+    }
+    uint16kernels_work_t *work = uint16kernels_new_work(len);
+    size_t *count = work->count[0];
+    for(size_t i=0; i < len; i++) {
+        work->scratch[i] = i;
+    }
+    uint16_t *src = work->scratch, *dest = idx;
+    for(uint8_t shift=0; shift < 16; shift += 8) {
+        memset(count, 0, 256 * sizeof(size_t));
+        for(size_t i=0; i < len; i++) {
+            count[(arr[i] >> shift) & 0xFF]++;
+        }
+        size_t offset = 0;
+        for(size_t b=0; b < 256; b++) {
+            size_t c = count[b];
+            count[b] = offset;
+            offset += c;
+        }
+        for(size_t i=0; i < len; i++) {
+            dest[count[(arr[src[i]] >> shift) & 0xFF]++] = src[i];
+        }
+        uint16_t *tmp = src;
+        src = dest;
+        dest = tmp;
+    }
+    // after an even number of passes, the result is back in scratch
+    memcpy(idx, src, len * sizeof(uint16_t));
+    free(work);
+}
+
+// Returns the first position, where value could be inserted without breaking the order;
+// with right set, the position after the last element equal to value is returned
+static inline size_t uint16kernels_bisect(const uint16_t *arr, size_t len, mp_int_t value, bool right) {
+    size_t lo = 0, hi = len;
+    while(lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if(right ? (arr[mid] <= value) : (arr[mid] < value)) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static inline bool uint16kernels_is_sorted(const uint16_t *arr, size_t len) {
+    for(size_t i=1; i < len; i++) {
+        if(arr[i] < arr[i-1]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Points *sorted to the elements in ascending order: to arr itself, if it is already sorted, or
+// else to a sorted copy. The returned block, if not NULL, has to be released with free().
+static inline void *uint16kernels_sorted(const uint16_t *arr, size_t len, const uint16_t **sorted) {
+    if(uint16kernels_is_sorted(arr, len)) {
+        *sorted = arr;
+        return NULL;
+    }
+    // the copy follows the scratch buffer in the same block
+    uint16kernels_work_t *work = uint16kernels_new_work(2 * len);
+    uint16_t *copy = work->scratch + len;
+    memcpy(copy, arr, len * sizeof(uint16_t));
+    uint16kernels_radix_sort(copy, work, len);
+    *sorted = copy;
+    return work;
+}
+
+// Copies the distinct values of the sorted array into out, and returns their number;
+// with out == NULL, the values are only counted
+static inline size_t uint16kernels_unique(const uint16_t *sorted, size_t len, uint16_t *out) {
+    if(len == 0) {
+        return 0;
+    }
+    size_t n = 1;
+    if(out != NULL) {
+        out[0] = sorted[0];
+    }
+    for(size_t i=1; i < len; i++) {
+        if(sorted[i] != sorted[i-1]) {
+            if(out != NULL) {
+                out[n] = sorted[i];
+            }
+            n++;
+        }
+    }
+    return n;
+}
+
+// Returns the elements of an array of 32-bit integers ('I', or 'i'), into which the binning kernels
+// below add their counts
+static inline uint32_t *uint16kernels_get_counts(mp_obj_t counts, size_t *len) {
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(counts, &bufinfo, MP_BUFFER_WRITE);
+    if(((bufinfo.typecode != 'I') && (bufinfo.typecode != 'i') && (bufinfo.typecode != 'L') && (bufinfo.typecode != 'l'))
+        || (mp_binary_get_size('@', bufinfo.typecode, NULL) != sizeof(uint32_t))) {
+        mp_raise_TypeError("counts must be an array of 32-bit integers");
+    }
+    *len = bufinfo.len / sizeof(uint32_t);
+    return bufinfo.buf;
+}
+
+// Bins [start, start + width*len(counts)) into len(counts) bins of equal width. The values that
+// fall outside of the range are not counted; their number is returned.
+static inline size_t uint16kernels_histogram(const uint16_t *arr, size_t len, uint32_t *counts, size_t nbins, mp_int_t start, mp_int_t width) {
+    size_t outside = 0;
+    if(width == 1) {
+        // direct indexing, e.g., for 8-bit readings with 256 bins
+        for(size_t i=0; i < len; i++) {
+            size_t bin = (size_t)(arr[i] - start);
+            if(bin < nbins) {
+                counts[bin]++;
+            } else {
+                outside++;
+            }
+        }
+    } else if((width & (width - 1)) == 0) {
+        uint8_t shift = 0;
+        while(((mp_int_t)1 << shift) < width) {
+            shift++;
+        }
+        for(size_t i=0; i < len; i++) {
+            mp_int_t offset = arr[i] - start;
+            size_t bin = (size_t)(offset >> shift);
+            if((offset >= 0) && (bin < nbins)) {
+                counts[bin]++;
+            } else {
+                outside++;
+            }
+        }
+    } else {
+        for(size_t i=0; i < len; i++) {
+            mp_int_t offset = arr[i] - start;
+            size_t bin = (size_t)(offset / width);
+            if((offset >= 0) && (bin < nbins)) {
+                counts[bin]++;
+            } else {
+                outside++;
+            }
+        }
+    }
+    return outside;
+}
+
+// Increments counts[i] for each value v with edges[i-1] <= v < edges[i], where edges are in
+// ascending order, and counts has nedges + 1 elements
+static inline void uint16kernels_bucketize(const uint16_t *arr, size_t len, const uint16_t *edges, size_t nedges, uint32_t *counts) {
+    for(size_t i=0; i < len; i++) {
+        counts[uint16kernels_bisect(edges, nedges, arr[i], true)]++;
+    }
+}
+
+// Replaces the counts by their running totals; the totals saturate at 2^32-1
+static inline void uint16kernels_cumulative(uint32_t *counts, size_t len) {
+    uint32_t total = 0;
+    for(size_t i=0; i < len; i++) {
+        total = (counts[i] > UINT32_MAX - total) ? UINT32_MAX : total + counts[i];
+        counts[i] = total;
+    }
+}
+
+#endif
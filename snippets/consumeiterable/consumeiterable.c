@@ -8,25 +8,318 @@
  * Copyright (c) 2019 Zoltán Vörös
 */
     
+#include <string.h>
 #include "py/obj.h"
 #include "py/runtime.h"
+#include "py/binary.h"
+#include "py/mpthread.h"
+#include "threadpool.h"
+#include "outarg.h"
+#include "pause.h"
+#include "instrument.h"
 
-STATIC mp_obj_t consumeiterable_sumsq(mp_obj_t o_in) {
+// Buffers shorter than this are summed up on the calling thread, because waking up the workers would cost more
+#ifndef CONSUMEITERABLE_PARALLEL_THRESHOLD
+#define CONSUMEITERABLE_PARALLEL_THRESHOLD (65536)
+#endif
+
+#define SUMSQ_LOOP(type, buf, start, end, sum) do {\
+    const type *_arr = (const type *)(buf);\
+    for(size_t _i=(start); _i < (end); _i++) {\
+        mp_float_t _item = (mp_float_t)_arr[_i];\
+        (sum) += _item*_item;\
+    }\
+} while(0)
+
+STATIC bool consumeiterable_is_numeric(int typecode) {
+    return (typecode == BYTEARRAY_TYPECODE) || ((typecode != 0) && (strchr("bBhHiIfd", typecode) != NULL));
+}
+
+// Sums the squares of the elements in [start, end) of a raw buffer
+STATIC mp_float_t consumeiterable_sumsq_buffer(const void *buf, int typecode, size_t start, size_t end) {
+    mp_float_t _sum = 0.0;
+    switch(typecode) {
+        case 'b': SUMSQ_LOOP(int8_t, buf, start, end, _sum); break;
+        case 'B': case BYTEARRAY_TYPECODE: SUMSQ_LOOP(uint8_t, buf, start, end, _sum); break;
+        case 'h': SUMSQ_LOOP(int16_t, buf, start, end, _sum); break;
+        case 'H': SUMSQ_LOOP(uint16_t, buf, start, end, _sum); break;
+        case 'i': SUMSQ_LOOP(int32_t, buf, start, end, _sum); break;
+        case 'I': SUMSQ_LOOP(uint32_t, buf, start, end, _sum); break;
+        case 'f': SUMSQ_LOOP(float, buf, start, end, _sum); break;
+        case 'd': SUMSQ_LOOP(double, buf, start, end, _sum); break;
+    }
+    return _sum;
+}
+
+#if CONSUMEITERABLE_USE_THREADS
+// The number of threads sharing the work of a single call; 1 switches the pool off
+STATIC size_t consumeiterable_threads = 0;
+
+typedef struct _sumsq_job_t {
+    const void *buf;
+    int typecode;
+    size_t start, end;
+    mp_float_t result;
+} sumsq_job_t;
+
+STATIC void consumeiterable_sumsq_job(void *arg) {
+    sumsq_job_t *job = arg;
+    job->result = consumeiterable_sumsq_buffer(job->buf, job->typecode, job->start, job->end);
+}
+
+// With release_gil set, other python threads can run while the workers are busy. This is safe only for
+// buffers that can't be resized, or freed in the meantime, e.g., bytes, or a read-only memoryview.
+// Otherwise, the work is still shared by the pool, but the GIL is held.
+STATIC mp_float_t consumeiterable_sumsq_parallel(const void *buf, int typecode, size_t len, size_t threads, bool release_gil) {
+    sumsq_job_t jobs[THREADPOOL_MAX_THREADS];
+    size_t start = 0;
+    for(size_t i=0; i < threads; i++) {
+        // the split depends only on the length and the number of threads
+        size_t end = start + len / threads + (i < len % threads ? 1 : 0);
+        jobs[i].buf = buf;
+        jobs[i].typecode = typecode;
+        jobs[i].start = start;
+        jobs[i].end = end;
+        start = end;
+    }
+    if(release_gil) {
+        MP_THREAD_GIL_EXIT();
+    }
+    threadpool_run(consumeiterable_sumsq_job, jobs, sizeof(sumsq_job_t), threads);
+    if(release_gil) {
+        MP_THREAD_GIL_ENTER();
+    }
+    // the partial sums are added in a fixed order, so that the result does not depend on the scheduling
+    mp_float_t _sum = 0.0;
+    for(size_t i=0; i < threads; i++) {
+        _sum += jobs[i].result;
+    }
+    return _sum;
+}
+
+STATIC mp_obj_t consumeiterable_set_threads(size_t n_args, const mp_obj_t *args) {
+    if(consumeiterable_threads == 0) {
+        consumeiterable_threads = threadpool_default_size();
+    }
+    if(n_args == 1) {
+        mp_int_t threads = mp_obj_get_int(args[0]);
+        if((threads < 1) || (threads > THREADPOOL_MAX_THREADS)) {
+            mp_raise_ValueError("number of threads is out of range");
+        }
+        consumeiterable_threads = threads;
+    }
+    return mp_obj_new_int(consumeiterable_threads);
+}
+
+INSTRUMENT_WRAP_VAR(consumeiterable_set_threads)
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(consumeiterable_set_threads_obj, 0, 1, INSTRUMENT(consumeiterable_set_threads));
+#endif
+
+STATIC mp_float_t consumeiterable_sumsq_float(mp_obj_t o_in) {
     mp_float_t _sum = 0.0, itemf;
+    mp_buffer_info_t bufinfo;
+    // arrays, bytes and the like are read directly, without boxing their elements
+    if(!mp_obj_is_str(o_in) && mp_get_buffer(o_in, &bufinfo, MP_BUFFER_READ) && consumeiterable_is_numeric(bufinfo.typecode)) {
+        size_t len = bufinfo.len / mp_binary_get_size('@', bufinfo.typecode, NULL);
+#if CONSUMEITERABLE_USE_THREADS
+        if(consumeiterable_threads == 0) {
+            consumeiterable_threads = threadpool_default_size();
+        }
+        if((len >= CONSUMEITERABLE_PARALLEL_THRESHOLD) && (consumeiterable_threads > 1)) {
+            // a bytearray, or an array can be extended by another thread, which moves its buffer
+            mp_buffer_info_t writeinfo;
+            bool immutable = !mp_get_buffer(o_in, &writeinfo, MP_BUFFER_WRITE);
+            return consumeiterable_sumsq_parallel(bufinfo.buf, bufinfo.typecode, len, consumeiterable_threads, immutable);
+        }
+#endif
+        return consumeiterable_sumsq_buffer(bufinfo.buf, bufinfo.typecode, 0, len);
+    }
     mp_obj_iter_buf_t iter_buf;
     mp_obj_t item, iterable = mp_getiter(o_in, &iter_buf);
     while ((item = mp_iternext(iterable)) != MP_OBJ_STOP_ITERATION) {
         itemf = mp_obj_get_float(item);
         _sum += itemf*itemf;
     }
+    return _sum;
+}
+
+// sumsq(iterable, *, out=None, index=0)
+//
+// With out, the result is written into out[index], and out is returned. Long numerical buffers are
+// shared by the thread pool. The GIL is released meanwhile only for bytes, and other read-only
+// buffers: for an array, or a bytearray, it stays held, and other python threads have to wait.
+STATIC mp_obj_t consumeiterable_sumsq(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_iterable, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_rom_obj = MP_ROM_NONE } },
+        { MP_QSTR_out, MP_ARG_KW_ONLY | MP_ARG_OBJ, {.u_rom_obj = MP_ROM_NONE } },
+        { MP_QSTR_index, MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = 0 } },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    mp_float_t _sum = consumeiterable_sumsq_float(args[0].u_obj);
+    if(args[1].u_obj != mp_const_none) {
+        outarg_store_float(args[1].u_obj, args[2].u_int, _sum);
+        return args[1].u_obj;
+    }
     return mp_obj_new_float(_sum);
 }
 
-STATIC MP_DEFINE_CONST_FUN_OBJ_1(consumeiterable_sumsq_obj, consumeiterable_sumsq);
+INSTRUMENT_WRAP_KW(consumeiterable_sumsq)
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(consumeiterable_sumsq_obj, 1, INSTRUMENT(consumeiterable_sumsq));
+
+// The number of elements that sumsq_async processes, before it lets the other tasks run
+#ifndef CONSUMEITERABLE_CHUNK
+#define CONSUMEITERABLE_CHUNK (1024)
+#endif
+
+// The state of a reduction that is carried out in chunks. The object is its own iterator,
+// so that it can be awaited, and each step of the iteration processes one chunk.
+typedef struct _consumeiterable_reduction_obj_t {
+    mp_obj_base_t base;
+    mp_obj_t iterable;
+    mp_obj_t iter; // MP_OBJ_NULL, if the iterable is read as a buffer
+    mp_obj_t pause; // uasyncio.sleep_ms, or MP_OBJ_NULL, if uasyncio is not available
+    mp_obj_t out;
+    mp_int_t index;
+    size_t chunk;
+    size_t pos;
+    mp_float_t sum;
+    bool done;
+    mp_obj_iter_buf_t iter_buf;
+} consumeiterable_reduction_obj_t;
+
+STATIC mp_obj_t consumeiterable_reduction_finish(consumeiterable_reduction_obj_t *self) {
+    self->done = true;
+    self->iterable = self->iter = mp_const_none;
+    if(self->out != mp_const_none) {
+        outarg_store_float(self->out, self->index, self->sum);
+    }
+    return MP_OBJ_STOP_ITERATION;
+}
+
+STATIC mp_obj_t consumeiterable_reduction_iternext(mp_obj_t self_in) {
+    consumeiterable_reduction_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if(self->done) {
+        return MP_OBJ_STOP_ITERATION;
+    }
+    if(self->iter == MP_OBJ_NULL) {
+        // the buffer is looked up anew for each chunk, because the array might have been changed in the meantime
+        mp_buffer_info_t bufinfo;
+        mp_get_buffer_raise(self->iterable, &bufinfo, MP_BUFFER_READ);
+        size_t len = bufinfo.len / mp_binary_get_size('@', bufinfo.typecode, NULL);
+        if(self->pos < len) {
+            size_t end = (len - self->pos > self->chunk) ? self->pos + self->chunk : len;
+            self->sum += consumeiterable_sumsq_buffer(bufinfo.buf, bufinfo.typecode, self->pos, end);
+            self->pos = end;
+        }
+        if(self->pos >= len) {
+            return consumeiterable_reduction_finish(self);
+        }
+    } else {
+        mp_obj_t item;
+        for(size_t i=0; i < self->chunk; i++) {
+            if((item = mp_iternext(self->iter)) == MP_OBJ_STOP_ITERATION) {
+                return consumeiterable_reduction_finish(self);
+            }
+            mp_float_t itemf = mp_obj_get_float(item);
+            self->sum += itemf*itemf;
+        }
+    }
+    return pause_yield(self->pause);
+}
+
+INSTRUMENT_WRAP_1(consumeiterable_reduction_iternext)
+
+// Returns the result of a finished reduction, or out, if it was given
+STATIC mp_obj_t consumeiterable_reduction_result(mp_obj_t self_in) {
+    consumeiterable_reduction_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if(!self->done) {
+        mp_raise_msg(&mp_type_RuntimeError, "reduction is not finished");
+    }
+    if(self->out != mp_const_none) {
+        return self->out;
+    }
+    return mp_obj_new_float(self->sum);
+}
+
+INSTRUMENT_WRAP_1(consumeiterable_reduction_result)
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(consumeiterable_reduction_result_obj, INSTRUMENT(consumeiterable_reduction_result));
+
+STATIC mp_obj_t consumeiterable_reduction_done(mp_obj_t self_in) {
+    consumeiterable_reduction_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    return mp_obj_new_bool(self->done);
+}
+
+INSTRUMENT_WRAP_1(consumeiterable_reduction_done)
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(consumeiterable_reduction_done_obj, INSTRUMENT(consumeiterable_reduction_done));
+
+STATIC const mp_rom_map_elem_t consumeiterable_reduction_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_result), MP_ROM_PTR(&consumeiterable_reduction_result_obj) },
+    { MP_ROM_QSTR(MP_QSTR_done), MP_ROM_PTR(&consumeiterable_reduction_done_obj) },
+};
+
+STATIC MP_DEFINE_CONST_DICT(consumeiterable_reduction_locals_dict, consumeiterable_reduction_locals_dict_table);
+
+const mp_obj_type_t consumeiterable_reduction_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_reduction,
+    .getiter = mp_identity_getiter,
+    .iternext = INSTRUMENT(consumeiterable_reduction_iternext),
+    .locals_dict = (mp_obj_dict_t*)&consumeiterable_reduction_locals_dict,
+};
+
+// sumsq_async(iterable, *, chunk=CONSUMEITERABLE_CHUNK, out=None, index=0)
+//
+// Returns a reduction object that can be awaited in a uasyncio task. The result is available
+// through its result() method, once the await has returned:
+//
+//     r = consumeiterable.sumsq_async(data)
+//     await r
+//     print(r.result())
+//
+// Threads are not used here, each chunk is summed up on the calling thread.
+STATIC mp_obj_t consumeiterable_sumsq_async(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_iterable, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_rom_obj = MP_ROM_NONE } },
+        { MP_QSTR_chunk, MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = CONSUMEITERABLE_CHUNK } },
+        { MP_QSTR_out, MP_ARG_KW_ONLY | MP_ARG_OBJ, {.u_rom_obj = MP_ROM_NONE } },
+        { MP_QSTR_index, MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = 0 } },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    if(args[1].u_int < 1) {
+        mp_raise_ValueError("chunk must be positive");
+    }
+    consumeiterable_reduction_obj_t *self = m_new_obj(consumeiterable_reduction_obj_t);
+    self->base.type = &consumeiterable_reduction_type;
+    self->iterable = args[0].u_obj;
+    self->iter = MP_OBJ_NULL;
+    self->out = args[2].u_obj;
+    self->index = args[3].u_int;
+    self->chunk = args[1].u_int;
+    self->pos = 0;
+    self->sum = 0.0;
+    self->done = false;
+    mp_buffer_info_t bufinfo;
+    if(mp_obj_is_str(self->iterable) || !mp_get_buffer(self->iterable, &bufinfo, MP_BUFFER_READ) || !consumeiterable_is_numeric(bufinfo.typecode)) {
+        self->iter = mp_getiter(self->iterable, &self->iter_buf);
+    }
+    self->pause = pause_get();
+    return MP_OBJ_FROM_PTR(self);
+}
+
+INSTRUMENT_WRAP_KW(consumeiterable_sumsq_async)
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(consumeiterable_sumsq_async_obj, 1, INSTRUMENT(consumeiterable_sumsq_async));
 
 STATIC const mp_rom_map_elem_t consumeiterable_module_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_consumeiterable) },
     { MP_ROM_QSTR(MP_QSTR_sumsq), MP_ROM_PTR(&consumeiterable_sumsq_obj) },
+    { MP_ROM_QSTR(MP_QSTR_sumsq_async), MP_ROM_PTR(&consumeiterable_sumsq_async_obj) },
+#if CONSUMEITERABLE_USE_THREADS
+    { MP_ROM_QSTR(MP_QSTR_threads), MP_ROM_PTR(&consumeiterable_set_threads_obj) },
+#endif
 };
 STATIC MP_DEFINE_CONST_DICT(consumeiterable_module_globals, consumeiterable_module_globals_table);
 
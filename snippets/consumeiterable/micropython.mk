@@ -1,6 +1,7 @@
 USERMODULES_DIR := $(USERMOD_DIR)
 
 # Add all C files to SRC_USERMOD.
+SRC_USERMOD += $(USERMODULES_DIR)/threadpool.c
 SRC_USERMOD += $(USERMODULES_DIR)/consumeiterable.c
 
-CFLAGS_USERMOD += -I$(USERMODULES_DIR)
\ No newline at end of file
+CFLAGS_USERMOD += -I$(USERMODULES_DIR) -I$(USERMODULES_DIR)/../common -I$(USERMODULES_DIR)/../instrument
\ No newline at end of file
@@ -0,0 +1,114 @@
+/*
+ * This file is part of the micropython-usermod project, 
+ *
+ * https://github.com/v923z/micropython-usermod
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Zoltán Vörös
+*/
+    
+#include "threadpool.h"
+
+#if CONSUMEITERABLE_USE_THREADS
+
+#include <pthread.h>
+#include <unistd.h>
+
+// The workers are plain pthreads: they are started on first use, live for the
+// rest of the session, and never touch python objects, only the raw memory
+// handed over in the job arguments.
+
+STATIC pthread_mutex_t threadpool_call_mutex = PTHREAD_MUTEX_INITIALIZER;
+STATIC pthread_mutex_t threadpool_mutex = PTHREAD_MUTEX_INITIALIZER;
+STATIC pthread_cond_t threadpool_work = PTHREAD_COND_INITIALIZER;
+STATIC pthread_cond_t threadpool_done = PTHREAD_COND_INITIALIZER;
+
+STATIC size_t threadpool_workers = 0;
+STATIC size_t threadpool_generation = 0;
+
+STATIC threadpool_job_t threadpool_job;
+STATIC char *threadpool_args;
+STATIC size_t threadpool_arg_size;
+STATIC size_t threadpool_n;
+STATIC size_t threadpool_next;
+STATIC size_t threadpool_pending;
+
+// Takes jobs until none are left; must be called with threadpool_mutex held
+STATIC void threadpool_drain(void) {
+    while(threadpool_next < threadpool_n) {
+        void *arg = threadpool_args + threadpool_next * threadpool_arg_size;
+        threadpool_job_t job = threadpool_job;
+        threadpool_next++;
+        pthread_mutex_unlock(&threadpool_mutex);
+        job(arg);
+        pthread_mutex_lock(&threadpool_mutex);
+        if(--threadpool_pending == 0) {
+            pthread_cond_signal(&threadpool_done);
+        }
+    }
+}
+
+STATIC void *threadpool_worker(void *unused) {
+    (void)unused;
+    pthread_mutex_lock(&threadpool_mutex);
+    // a worker started by threadpool_run gets the mutex only after the jobs have been posted,
+    // so it takes its share of those, before it waits for the next call
+    size_t seen = threadpool_generation;
+    threadpool_drain();
+    for(;;) {
+        while(threadpool_generation == seen) {
+            pthread_cond_wait(&threadpool_work, &threadpool_mutex);
+        }
+        seen = threadpool_generation;
+        threadpool_drain();
+    }
+    return NULL;
+}
+
+size_t threadpool_default_size(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    if(n < 1) {
+        return 1;
+    }
+    return n > THREADPOOL_MAX_THREADS ? THREADPOOL_MAX_THREADS : (size_t)n;
+}
+
+// Calls job on each of the n arguments stored back to back in args, and returns
+// after all of them have finished. The calling thread works on the jobs, too.
+// The GIL should be released by the caller.
+void threadpool_run(threadpool_job_t job, void *args, size_t arg_size, size_t n) {
+    // only one call can own the pool at a time
+    pthread_mutex_lock(&threadpool_call_mutex);
+    pthread_mutex_lock(&threadpool_mutex);
+    size_t wanted = n > THREADPOOL_MAX_THREADS ? THREADPOOL_MAX_THREADS - 1 : n - 1;
+    while(threadpool_workers < wanted) {
+        pthread_t thread;
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        int failed = pthread_create(&thread, &attr, threadpool_worker, NULL);
+        pthread_attr_destroy(&attr);
+        if(failed) {
+            // carry on with the workers that we already have
+            break;
+        }
+        threadpool_workers++;
+    }
+    threadpool_job = job;
+    threadpool_args = args;
+    threadpool_arg_size = arg_size;
+    threadpool_n = n;
+    threadpool_next = 0;
+    threadpool_pending = n;
+    threadpool_generation++;
+    pthread_cond_broadcast(&threadpool_work);
+    threadpool_drain();
+    while(threadpool_pending != 0) {
+        pthread_cond_wait(&threadpool_done, &threadpool_mutex);
+    }
+    pthread_mutex_unlock(&threadpool_mutex);
+    pthread_mutex_unlock(&threadpool_call_mutex);
+}
+
+#endif
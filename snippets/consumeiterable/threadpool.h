@@ -0,0 +1,40 @@
+/*
+ * This file is part of the micropython-usermod project, 
+ *
+ * https://github.com/v923z/micropython-usermod
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Zoltán Vörös
+*/
+    
+#ifndef _THREADPOOL_H_
+#define _THREADPOOL_H_
+
+#include <stddef.h>
+#include "py/mpconfig.h"
+
+// The worker pool is available only on the unix port with threading enabled
+#ifndef CONSUMEITERABLE_USE_THREADS
+#if MICROPY_PY_THREAD && defined(__unix__)
+#define CONSUMEITERABLE_USE_THREADS (1)
+#else
+#define CONSUMEITERABLE_USE_THREADS (0)
+#endif
+#endif
+
+// The upper limit on the number of threads taking part in a single call, including the caller
+#ifndef THREADPOOL_MAX_THREADS
+#define THREADPOOL_MAX_THREADS (16)
+#endif
+
+#if CONSUMEITERABLE_USE_THREADS
+
+typedef void (*threadpool_job_t)(void *);
+
+size_t threadpool_default_size(void);
+void threadpool_run(threadpool_job_t , void *, size_t , size_t );
+
+#endif
+
+#endif
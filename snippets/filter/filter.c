@@ -0,0 +1,289 @@
+/*
+ * This file is part of the micropython-usermod project, 
+ *
+ * https://github.com/v923z/micropython-usermod
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020 Zoltán Vörös
+*/
+    
+#include <math.h>
+#include <string.h>
+#include "py/obj.h"
+#include "py/runtime.h"
+#include "py/binary.h"
+#include "instrument.h"
+
+// The samples are converted to float in blocks of this many elements, filtered, and converted
+// back to the type of the output, so that the filters themselves work on a single type only
+#ifndef FILTER_BLOCK_SIZE
+#define FILTER_BLOCK_SIZE (64)
+#endif
+
+STATIC bool filter_is_numeric(int typecode) {
+    return (typecode != 0) && (strchr("bBhHiIfd", typecode) != NULL);
+}
+
+STATIC void filter_load(const void *buf, int typecode, size_t start, size_t n, float *dest) {
+    for(size_t i=0; i < n; i++) {
+        switch(typecode) {
+            case 'b': dest[i] = ((const int8_t *)buf)[start + i]; break;
+            case 'B': dest[i] = ((const uint8_t *)buf)[start + i]; break;
+            case 'h': dest[i] = ((const int16_t *)buf)[start + i]; break;
+            case 'H': dest[i] = ((const uint16_t *)buf)[start + i]; break;
+            case 'i': dest[i] = ((const int32_t *)buf)[start + i]; break;
+            case 'I': dest[i] = ((const uint32_t *)buf)[start + i]; break;
+            case 'f': dest[i] = ((const float *)buf)[start + i]; break;
+            default: dest[i] = (float)((const double *)buf)[start + i]; break;
+        }
+    }
+}
+
+// Integers are rounded to nearest, and saturate at the limits of their type. NaN would fail
+// both comparisons, and has no integer value, so it is stored as 0.
+#define FILTER_STORE_INT(type, min, max) do {\
+    float _y = src[i];\
+    _y = _y < 0.0f ? _y - 0.5f : _y + 0.5f;\
+    ((type *)buf)[start + i] = isnan(_y) ? 0 : (_y <= (float)(min) ? (min) : (_y >= (float)(max) ? (max) : (type)_y));\
+} while(0)
+
+STATIC void filter_store(void *buf, int typecode, size_t start, size_t n, const float *src) {
+    for(size_t i=0; i < n; i++) {
+        switch(typecode) {
+            case 'b': FILTER_STORE_INT(int8_t, INT8_MIN, INT8_MAX); break;
+            case 'B': FILTER_STORE_INT(uint8_t, 0, UINT8_MAX); break;
+            case 'h': FILTER_STORE_INT(int16_t, INT16_MIN, INT16_MAX); break;
+            case 'H': FILTER_STORE_INT(uint16_t, 0, UINT16_MAX); break;
+            case 'i': FILTER_STORE_INT(int32_t, INT32_MIN, INT32_MAX); break;
+            case 'I': FILTER_STORE_INT(uint32_t, 0, UINT32_MAX); break;
+            case 'f': ((float *)buf)[start + i] = src[i]; break;
+            default: ((double *)buf)[start + i] = src[i]; break;
+        }
+    }
+}
+
+// Reads the coefficients from an iterable, and returns their number
+STATIC size_t filter_get_coefficients(mp_obj_t o_in, float **coeffs) {
+    size_t len = mp_obj_get_int(mp_obj_len(o_in));
+    *coeffs = m_new(float, len);
+    mp_obj_iter_buf_t iter_buf;
+    mp_obj_t item, iterable = mp_getiter(o_in, &iter_buf);
+    for(size_t i=0; (i < len) && ((item = mp_iternext(iterable)) != MP_OBJ_STOP_ITERATION); i++) {
+        (*coeffs)[i] = mp_obj_get_float(item);
+    }
+    return len;
+}
+
+typedef void (*filter_kernel_t)(mp_obj_t , float *, size_t );
+
+// Runs the kernel over input in blocks, and writes the result into output, which may be the input itself
+STATIC mp_obj_t filter_process(mp_obj_t self_in, mp_obj_t input, mp_obj_t output, filter_kernel_t kernel) {
+    mp_buffer_info_t in, out;
+    mp_get_buffer_raise(input, &in, MP_BUFFER_READ);
+    mp_get_buffer_raise(output, &out, MP_BUFFER_WRITE);
+    if(!filter_is_numeric(in.typecode) || !filter_is_numeric(out.typecode)) {
+        mp_raise_TypeError("arrays must be of a numerical type");
+    }
+    size_t len = in.len / mp_binary_get_size('@', in.typecode, NULL);
+    if(out.len / mp_binary_get_size('@', out.typecode, NULL) < len) {
+        mp_raise_ValueError("output is shorter than input");
+    }
+    float block[FILTER_BLOCK_SIZE];
+    for(size_t start=0; start < len; start += FILTER_BLOCK_SIZE) {
+        size_t n = len - start < FILTER_BLOCK_SIZE ? len - start : FILTER_BLOCK_SIZE;
+        filter_load(in.buf, in.typecode, start, n, block);
+        kernel(self_in, block, n);
+        filter_store(out.buf, out.typecode, start, n, block);
+    }
+    return output;
+}
+
+// FIR filter. The delay line is stored twice, back to back, so that the most recent taps are
+// always contiguous, and the convolution runs without wrapping the index.
+typedef struct _filter_fir_obj_t {
+    mp_obj_base_t base;
+    size_t taps;
+    size_t pos;
+    float *coeffs;
+    float *state;
+} filter_fir_obj_t;
+
+const mp_obj_type_t filter_fir_type;
+
+// fir(coefficients), where coefficients[0] multiplies the most recent sample
+STATIC mp_obj_t filter_fir_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    mp_arg_check_num(n_args, n_kw, 1, 1, true);
+    filter_fir_obj_t *self = m_new_obj(filter_fir_obj_t);
+    self->base.type = &filter_fir_type;
+    float *coeffs;
+    self->taps = filter_get_coefficients(args[0], &coeffs);
+    if(self->taps == 0) {
+        mp_raise_ValueError("no coefficients were given");
+    }
+    // the coefficients are stored in reverse, so that they line up with the delay line
+    self->coeffs = m_new(float, self->taps);
+    for(size_t i=0; i < self->taps; i++) {
+        self->coeffs[i] = coeffs[self->taps - 1 - i];
+    }
+    m_del(float, coeffs, self->taps);
+    self->state = m_new0(float, 2 * self->taps);
+    self->pos = 0;
+    return MP_OBJ_FROM_PTR(self);
+}
+
+STATIC void filter_fir_kernel(mp_obj_t self_in, float *samples, size_t n) {
+    filter_fir_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    size_t taps = self->taps;
+    const float *coeffs = self->coeffs;
+    for(size_t i=0; i < n; i++) {
+        // the oldest sample at pos is replaced, and the window [pos+1, pos+taps] holds the last taps samples
+        self->state[self->pos] = self->state[self->pos + taps] = samples[i];
+        self->pos = self->pos + 1 == taps ? 0 : self->pos + 1;
+        const float *x = self->state + self->pos;
+        float acc = 0.0f;
+        for(size_t k=0; k < taps; k++) {
+            acc += coeffs[k] * x[k];
+        }
+        samples[i] = acc;
+    }
+}
+
+// process(input, output)
+//
+// Filters the input array into the output array, and returns the output. The arrays can be of any
+// numerical type, and the output can be the input itself. The state is kept between the calls.
+STATIC mp_obj_t filter_fir_process(mp_obj_t self_in, mp_obj_t input, mp_obj_t output) {
+    return filter_process(self_in, input, output, filter_fir_kernel);
+}
+
+INSTRUMENT_WRAP_3(filter_fir_process)
+STATIC MP_DEFINE_CONST_FUN_OBJ_3(filter_fir_process_obj, INSTRUMENT(filter_fir_process));
+
+STATIC mp_obj_t filter_fir_reset(mp_obj_t self_in) {
+    filter_fir_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    memset(self->state, 0, 2 * self->taps * sizeof(float));
+    self->pos = 0;
+    return mp_const_none;
+}
+
+INSTRUMENT_WRAP_1(filter_fir_reset)
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(filter_fir_reset_obj, INSTRUMENT(filter_fir_reset));
+
+STATIC const mp_rom_map_elem_t filter_fir_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_process), MP_ROM_PTR(&filter_fir_process_obj) },
+    { MP_ROM_QSTR(MP_QSTR_reset), MP_ROM_PTR(&filter_fir_reset_obj) },
+};
+
+STATIC MP_DEFINE_CONST_DICT(filter_fir_locals_dict, filter_fir_locals_dict_table);
+
+const mp_obj_type_t filter_fir_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_fir,
+    .make_new = filter_fir_make_new,
+    .locals_dict = (mp_obj_dict_t*)&filter_fir_locals_dict,
+};
+
+// Cascade of second-order IIR sections, in transposed direct form II
+typedef struct _filter_biquad_obj_t {
+    mp_obj_base_t base;
+    size_t sections;
+    float *coeffs; // b0, b1, b2, a1, a2 for each section
+    float *state; // two delays for each section
+} filter_biquad_obj_t;
+
+const mp_obj_type_t filter_biquad_type;
+
+// biquad(sos)
+//
+// sos holds six coefficients, b0, b1, b2, a0, a1, a2 for each section, as in scipy.signal
+STATIC mp_obj_t filter_biquad_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    mp_arg_check_num(n_args, n_kw, 1, 1, true);
+    filter_biquad_obj_t *self = m_new_obj(filter_biquad_obj_t);
+    self->base.type = &filter_biquad_type;
+    float *sos;
+    size_t len = filter_get_coefficients(args[0], &sos);
+    if((len == 0) || (len % 6 != 0)) {
+        mp_raise_ValueError("sos must have 6 coefficients per section");
+    }
+    self->sections = len / 6;
+    self->coeffs = m_new(float, 5 * self->sections);
+    for(size_t s=0; s < self->sections; s++) {
+        float *c = sos + 6 * s;
+        if(c[3] == 0.0f) {
+            mp_raise_ValueError("a0 must not be 0");
+        }
+        for(uint8_t k=0; k < 3; k++) {
+            self->coeffs[5 * s + k] = c[k] / c[3];
+        }
+        self->coeffs[5 * s + 3] = c[4] / c[3];
+        self->coeffs[5 * s + 4] = c[5] / c[3];
+    }
+    m_del(float, sos, len);
+    self->state = m_new0(float, 2 * self->sections);
+    return MP_OBJ_FROM_PTR(self);
+}
+
+STATIC void filter_biquad_kernel(mp_obj_t self_in, float *samples, size_t n) {
+    filter_biquad_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    // each section runs over the whole block, while its coefficients and delays are in registers
+    for(size_t s=0; s < self->sections; s++) {
+        const float *c = self->coeffs + 5 * s;
+        float b0 = c[0], b1 = c[1], b2 = c[2], a1 = c[3], a2 = c[4];
+        float d1 = self->state[2 * s], d2 = self->state[2 * s + 1];
+        for(size_t i=0; i < n; i++) {
+            float x = samples[i];
+            float y = b0 * x + d1;
+            d1 = b1 * x - a1 * y + d2;
+            d2 = b2 * x - a2 * y;
+            samples[i] = y;
+        }
+        self->state[2 * s] = d1;
+        self->state[2 * s + 1] = d2;
+    }
+}
+
+// process(input, output), the same as for fir
+STATIC mp_obj_t filter_biquad_process(mp_obj_t self_in, mp_obj_t input, mp_obj_t output) {
+    return filter_process(self_in, input, output, filter_biquad_kernel);
+}
+
+INSTRUMENT_WRAP_3(filter_biquad_process)
+STATIC MP_DEFINE_CONST_FUN_OBJ_3(filter_biquad_process_obj, INSTRUMENT(filter_biquad_process));
+
+STATIC mp_obj_t filter_biquad_reset(mp_obj_t self_in) {
+    filter_biquad_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    memset(self->state, 0, 2 * self->sections * sizeof(float));
+    return mp_const_none;
+}
+
+INSTRUMENT_WRAP_1(filter_biquad_reset)
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(filter_biquad_reset_obj, INSTRUMENT(filter_biquad_reset));
+
+STATIC const mp_rom_map_elem_t filter_biquad_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_process), MP_ROM_PTR(&filter_biquad_process_obj) },
+    { MP_ROM_QSTR(MP_QSTR_reset), MP_ROM_PTR(&filter_biquad_reset_obj) },
+};
+
+STATIC MP_DEFINE_CONST_DICT(filter_biquad_locals_dict, filter_biquad_locals_dict_table);
+
+const mp_obj_type_t filter_biquad_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_biquad,
+    .make_new = filter_biquad_make_new,
+    .locals_dict = (mp_obj_dict_t*)&filter_biquad_locals_dict,
+};
+
+STATIC const mp_rom_map_elem_t filter_module_globals_table[] = {
+    { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_filter) },
+    { MP_ROM_QSTR(MP_QSTR_fir), MP_ROM_PTR(&filter_fir_type) },
+    { MP_ROM_QSTR(MP_QSTR_biquad), MP_ROM_PTR(&filter_biquad_type) },
+};
+STATIC MP_DEFINE_CONST_DICT(filter_module_globals, filter_module_globals_table);
+
+const mp_obj_module_t filter_user_cmodule = {
+    .base = { &mp_type_module },
+    .globals = (mp_obj_dict_t*)&filter_module_globals,
+};
+
+MP_REGISTER_MODULE(MP_QSTR_filter, filter_user_cmodule, MODULE_FILTER_ENABLED);
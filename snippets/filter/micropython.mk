@@ -0,0 +1,6 @@
+USERMODULES_DIR := $(USERMOD_DIR)
+
+# Add all C files to SRC_USERMOD.
+SRC_USERMOD += $(USERMODULES_DIR)/filter.c
+
+CFLAGS_USERMOD += -I$(USERMODULES_DIR) -I$(USERMODULES_DIR)/../instrument
\ No newline at end of file
@@ -0,0 +1,90 @@
+/*
+ * This file is part of the micropython-usermod project, 
+ *
+ * https://github.com/v923z/micropython-usermod
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020 Zoltán Vörös
+*/
+    
+#include <string.h>
+#include "py/obj.h"
+#include "py/runtime.h"
+#include "record.h"
+#include "instrument.h"
+
+#if MODULE_INSTRUMENT_ENABLED
+
+#include "mphalport.h"  // needed for mp_hal_ticks_cpu()
+
+#ifndef INSTRUMENT_TICKS
+#define INSTRUMENT_TICKS() mp_hal_ticks_cpu()
+#endif
+
+#if MICROPY_MEM_STATS
+#define INSTRUMENT_BYTES() m_get_total_bytes_allocated()
+#else
+#define INSTRUMENT_BYTES() (0)
+#endif
+
+// The counters live in static storage next to the functions that they count, and are linked
+// into this list on their first call, so that no table has to be maintained by hand
+STATIC instrument_counter_t *instrument_counters = NULL;
+
+void instrument_enter(instrument_counter_t *counter, instrument_probe_t *probe) {
+    if(!counter->registered) {
+        counter->next = instrument_counters;
+        instrument_counters = counter;
+        counter->registered = true;
+    }
+    counter->calls++;
+    probe->bytes = INSTRUMENT_BYTES();
+    probe->ticks = INSTRUMENT_TICKS();
+}
+
+void instrument_exit(instrument_counter_t *counter, instrument_probe_t *probe) {
+    counter->ticks += INSTRUMENT_TICKS() - probe->ticks;
+    counter->bytes += INSTRUMENT_BYTES() - probe->bytes;
+}
+
+// Returns a list of counter records with the fields name, calls, ticks, and bytes for the
+// entry points that have been called since the last dump, and resets their counters
+STATIC const qstr instrument_fields[] = { MP_QSTR_name, MP_QSTR_calls, MP_QSTR_ticks, MP_QSTR_bytes };
+STATIC const record_type_t instrument_type = RECORD_TYPE(MP_QSTR_counter, instrument_fields);
+
+STATIC mp_obj_t instrument_dump(void) {
+    mp_obj_t list = mp_obj_new_list(0, NULL);
+    for(instrument_counter_t *counter = instrument_counters; counter != NULL; counter = counter->next) {
+        if(counter->calls == 0) {
+            continue;
+        }
+        mp_obj_t items[4];
+        items[0] = mp_obj_new_str(counter->name, strlen(counter->name));
+        items[1] = mp_obj_new_int_from_uint(counter->calls);
+        items[2] = mp_obj_new_int_from_uint(counter->ticks);
+        items[3] = mp_obj_new_int_from_uint(counter->bytes);
+        mp_obj_list_append(list, record_new(&instrument_type, items));
+        counter->calls = 0;
+        counter->ticks = 0;
+        counter->bytes = 0;
+    }
+    return list;
+}
+
+STATIC MP_DEFINE_CONST_FUN_OBJ_0(instrument_dump_obj, instrument_dump);
+
+STATIC const mp_rom_map_elem_t instrument_module_globals_table[] = {
+    { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_instrument) },
+    { MP_ROM_QSTR(MP_QSTR_dump), MP_ROM_PTR(&instrument_dump_obj) },
+};
+STATIC MP_DEFINE_CONST_DICT(instrument_module_globals, instrument_module_globals_table);
+
+const mp_obj_module_t instrument_user_cmodule = {
+    .base = { &mp_type_module },
+    .globals = (mp_obj_dict_t*)&instrument_module_globals,
+};
+
+#endif
+
+MP_REGISTER_MODULE(MP_QSTR_instrument, instrument_user_cmodule, MODULE_INSTRUMENT_ENABLED);
@@ -0,0 +1,108 @@
+/*
+ * This file is part of the micropython-usermod project, 
+ *
+ * https://github.com/v923z/micropython-usermod
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020 Zoltán Vörös
+*/
+    
+#ifndef _INSTRUMENT_H_
+#define _INSTRUMENT_H_
+
+#include "py/obj.h"
+
+// With MODULE_INSTRUMENT_ENABLED set, each entry point wrapped with one of the INSTRUMENT_WRAP_* macros
+// counts its calls, and adds up the ticks of mp_hal_ticks_cpu() and the bytes allocated in it. The
+// counters can be read out, and reset by instrument.dump(). Otherwise, the macros expand to nothing,
+// and INSTRUMENT(fun) to fun itself. The wrappers are defined as
+//
+//     INSTRUMENT_WRAP_1(vector_length)
+//     STATIC MP_DEFINE_CONST_FUN_OBJ_1(vector_length_obj, INSTRUMENT(vector_length));
+//
+// The macros are followed by no semicolon. A call that raises an exception is counted, but
+// its ticks and bytes are not. The modules find this header through the
+// -I$(USERMODULES_DIR)/../instrument flag in their micropython.mk.
+
+#if MODULE_INSTRUMENT_ENABLED
+
+typedef struct _instrument_counter_t {
+    struct _instrument_counter_t *next;
+    const char *name;
+    bool registered; // true, once the counter has been linked into the list of counters
+    size_t calls;
+    mp_uint_t ticks;
+    size_t bytes;
+} instrument_counter_t;
+
+typedef struct _instrument_probe_t {
+    mp_uint_t ticks;
+    size_t bytes;
+} instrument_probe_t;
+
+void instrument_enter(instrument_counter_t *, instrument_probe_t *);
+void instrument_exit(instrument_counter_t *, instrument_probe_t *);
+
+#define INSTRUMENT(fun) fun##_instrumented
+
+#define INSTRUMENT_COUNTER(fun) \
+    STATIC instrument_counter_t fun##_counter = { NULL, #fun, false, 0, 0, 0 };
+
+#define INSTRUMENT_CALL(fun, call) \
+    instrument_probe_t probe;\
+    instrument_enter(&fun##_counter, &probe);\
+    mp_obj_t res = (call);\
+    instrument_exit(&fun##_counter, &probe);\
+    return res;
+
+#define INSTRUMENT_WRAP_0(fun) INSTRUMENT_COUNTER(fun)\
+    STATIC mp_obj_t fun##_instrumented(void) {\
+        INSTRUMENT_CALL(fun, fun())\
+    }
+
+#define INSTRUMENT_WRAP_1(fun) INSTRUMENT_COUNTER(fun)\
+    STATIC mp_obj_t fun##_instrumented(mp_obj_t a) {\
+        INSTRUMENT_CALL(fun, fun(a))\
+    }
+
+#define INSTRUMENT_WRAP_2(fun) INSTRUMENT_COUNTER(fun)\
+    STATIC mp_obj_t fun##_instrumented(mp_obj_t a, mp_obj_t b) {\
+        INSTRUMENT_CALL(fun, fun(a, b))\
+    }
+
+// the subscr slot of types has the same signature
+#define INSTRUMENT_WRAP_3(fun) INSTRUMENT_COUNTER(fun)\
+    STATIC mp_obj_t fun##_instrumented(mp_obj_t a, mp_obj_t b, mp_obj_t c) {\
+        INSTRUMENT_CALL(fun, fun(a, b, c))\
+    }
+
+#define INSTRUMENT_WRAP_VAR(fun) INSTRUMENT_COUNTER(fun)\
+    STATIC mp_obj_t fun##_instrumented(size_t n_args, const mp_obj_t *args) {\
+        INSTRUMENT_CALL(fun, fun(n_args, args))\
+    }
+
+#define INSTRUMENT_WRAP_KW(fun) INSTRUMENT_COUNTER(fun)\
+    STATIC mp_obj_t fun##_instrumented(size_t n_args, const mp_obj_t *args, mp_map_t *kw_args) {\
+        INSTRUMENT_CALL(fun, fun(n_args, args, kw_args))\
+    }
+
+#define INSTRUMENT_WRAP_BINARY_OP(fun) INSTRUMENT_COUNTER(fun)\
+    STATIC mp_obj_t fun##_instrumented(mp_binary_op_t op, mp_obj_t lhs, mp_obj_t rhs) {\
+        INSTRUMENT_CALL(fun, fun(op, lhs, rhs))\
+    }
+
+#else
+
+#define INSTRUMENT(fun) fun
+#define INSTRUMENT_WRAP_0(fun)
+#define INSTRUMENT_WRAP_1(fun)
+#define INSTRUMENT_WRAP_2(fun)
+#define INSTRUMENT_WRAP_3(fun)
+#define INSTRUMENT_WRAP_VAR(fun)
+#define INSTRUMENT_WRAP_KW(fun)
+#define INSTRUMENT_WRAP_BINARY_OP(fun)
+
+#endif
+
+#endif
@@ -0,0 +1,6 @@
+USERMODULES_DIR := $(USERMOD_DIR)
+
+# Add all C files to SRC_USERMOD.
+SRC_USERMOD += $(USERMODULES_DIR)/instrument.c
+
+CFLAGS_USERMOD += -I$(USERMODULES_DIR) -I$(USERMODULES_DIR)/../common
\ No newline at end of file
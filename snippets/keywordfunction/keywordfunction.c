@@ -12,6 +12,7 @@
 #include "py/obj.h"
 #include "py/runtime.h"
 #include "py/builtin.h"
+#include "instrument.h"
 
 STATIC mp_obj_t keywordfunction_add_ints(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
     static const mp_arg_t allowed_args[] = {
@@ -27,7 +28,8 @@ STATIC mp_obj_t keywordfunction_add_ints(size_t n_args, const mp_obj_t *pos_args
     return mp_obj_new_int(a + b);
 }
 
-STATIC MP_DEFINE_CONST_FUN_OBJ_KW(keywordfunction_add_ints_obj, 1, keywordfunction_add_ints);
+INSTRUMENT_WRAP_KW(keywordfunction_add_ints)
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(keywordfunction_add_ints_obj, 1, INSTRUMENT(keywordfunction_add_ints));
 
 STATIC const mp_rom_map_elem_t keywordfunction_module_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_keywordfunction) },
@@ -11,10 +11,13 @@
 #include "py/obj.h"
 #include "py/runtime.h"
 #include "helper.h"
+#include "instrument.h"
 
 
-STATIC MP_DEFINE_CONST_FUN_OBJ_2(largemodule_add_ints_obj, largemodule_add_ints);
-STATIC MP_DEFINE_CONST_FUN_OBJ_2(largemodule_subtract_ints_obj, largemodule_subtract_ints);
+INSTRUMENT_WRAP_2(largemodule_add_ints)
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(largemodule_add_ints_obj, INSTRUMENT(largemodule_add_ints));
+INSTRUMENT_WRAP_2(largemodule_subtract_ints)
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(largemodule_subtract_ints_obj, INSTRUMENT(largemodule_subtract_ints));
 
 STATIC const mp_rom_map_elem_t largemodule_module_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_largemodule) },
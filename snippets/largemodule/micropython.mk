@@ -4,4 +4,4 @@ USERMODULES_DIR := $(USERMOD_DIR)
 SRC_USERMOD += $(USERMODULES_DIR)/helper.c
 SRC_USERMOD += $(USERMODULES_DIR)/largemodule.c
 
-CFLAGS_USERMOD += -I$(USERMODULES_DIR)
\ No newline at end of file
+CFLAGS_USERMOD += -I$(USERMODULES_DIR) -I$(USERMODULES_DIR)/../instrument
\ No newline at end of file
@@ -4,5 +4,5 @@ USERMODULES_DIR := $(USERMOD_DIR)
 SRC_USERMOD += $(USERMODULES_DIR)/profiling.c
 
 # We can add our module folder to include paths if needed
-# This is not actually needed in this example.
-CFLAGS_USERMOD += -I$(USERMODULES_DIR)
\ No newline at end of file
+# The shared helpers in ../common are header-only.
+CFLAGS_USERMOD += -I$(USERMODULES_DIR) -I$(USERMODULES_DIR)/../common -I$(USERMODULES_DIR)/../instrument
\ No newline at end of file
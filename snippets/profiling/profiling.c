@@ -12,29 +12,59 @@
 #include <stdio.h>
 #include "py/obj.h"
 #include "py/runtime.h"
+#include "py/binary.h"
 #include "mphalport.h"  // needed for mp_hal_ticks_cpu()
 #include "py/builtin.h" // needed for mp_micropython_mem_info()
+#include "record.h"
+#include "outarg.h"
+#include "instrument.h"
+
+// measure(x, y, z, *, out=None, index=0)
+//
+// Without out, the result is a measurement record with the fields start, middle, end, and
+// hypotenuse, which also unpacks as a tuple. With out, these four values are written into
+// out[index:index+4], and out is returned, so that nothing is allocated.
+STATIC const qstr measure_fields[] = { MP_QSTR_start, MP_QSTR_middle, MP_QSTR_end, MP_QSTR_hypotenuse };
+STATIC const record_type_t measure_type = RECORD_TYPE(MP_QSTR_measurement, measure_fields);
+
+STATIC mp_obj_t measure_cpu(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_x, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_rom_obj = MP_ROM_NONE } },
+        { MP_QSTR_y, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_rom_obj = MP_ROM_NONE } },
+        { MP_QSTR_z, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_rom_obj = MP_ROM_NONE } },
+        { MP_QSTR_out, MP_ARG_KW_ONLY | MP_ARG_OBJ, {.u_rom_obj = MP_ROM_NONE } },
+        { MP_QSTR_index, MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = 0 } },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
 
-STATIC mp_obj_t measure_cpu(mp_obj_t _x, mp_obj_t _y, mp_obj_t _z) {
     size_t start, middle, end;
     start = m_get_current_bytes_allocated();
 
-    float x = mp_obj_get_float(_x);
-    float y = mp_obj_get_float(_y);
-    float z = mp_obj_get_float(_z);
+    float x = mp_obj_get_float(args[0].u_obj);
+    float y = mp_obj_get_float(args[1].u_obj);
+    float z = mp_obj_get_float(args[2].u_obj);
     middle = m_get_current_bytes_allocated();
 
     float hypo = sqrtf(x*x + y*y + z*z);
     end = m_get_current_bytes_allocated();
-    mp_obj_t tuple[4];
-    tuple[0] = MP_OBJ_NEW_SMALL_INT(start);
-    tuple[1] = MP_OBJ_NEW_SMALL_INT(middle);
-    tuple[2] = MP_OBJ_NEW_SMALL_INT(end);
-    tuple[3] = mp_obj_new_float(hypo);
-    return mp_obj_new_tuple(4, tuple);
+
+    if(args[3].u_obj != mp_const_none) {
+        mp_float_t values[4] = { start, middle, end, hypo };
+        outarg_store_floats(args[3].u_obj, args[4].u_int, values, 4);
+        return args[3].u_obj;
+    }
+
+    mp_obj_t items[4];
+    items[0] = MP_OBJ_NEW_SMALL_INT(start);
+    items[1] = MP_OBJ_NEW_SMALL_INT(middle);
+    items[2] = MP_OBJ_NEW_SMALL_INT(end);
+    items[3] = mp_obj_new_float(hypo);
+    return record_new(&measure_type, items);
 }
 
-STATIC MP_DEFINE_CONST_FUN_OBJ_3(measure_cpu_obj, measure_cpu);
+INSTRUMENT_WRAP_KW(measure_cpu)
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(measure_cpu_obj, 3, INSTRUMENT(measure_cpu));
 
 STATIC const mp_rom_map_elem_t profiling_module_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_profiling) },
@@ -11,6 +11,7 @@
 #include <stdio.h>
 #include "py/runtime.h"
 #include "py/obj.h"
+#include "instrument.h"
 
 typedef struct _propertyclass_obj_t {
     mp_obj_base_t base;
@@ -32,7 +33,8 @@ STATIC mp_obj_t propertyclass_x(mp_obj_t self_in) {
     return mp_obj_new_float(self->x);
 }
 
-MP_DEFINE_CONST_FUN_OBJ_1(propertyclass_x_obj, propertyclass_x);
+INSTRUMENT_WRAP_1(propertyclass_x)
+MP_DEFINE_CONST_FUN_OBJ_1(propertyclass_x_obj, INSTRUMENT(propertyclass_x));
 
 STATIC const mp_rom_map_elem_t propertyclass_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_x), MP_ROM_PTR(&propertyclass_x_obj) },
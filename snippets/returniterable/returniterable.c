@@ -10,6 +10,7 @@
     
 #include "py/obj.h"
 #include "py/runtime.h"
+#include "instrument.h"
 
 STATIC mp_obj_t powers_iterable(mp_obj_t base, mp_obj_t exponent) {
     int e = mp_obj_get_int(exponent);
@@ -22,7 +23,8 @@ STATIC mp_obj_t powers_iterable(mp_obj_t base, mp_obj_t exponent) {
     return mp_obj_new_tuple(e+1, tuple);
 }
 
-STATIC MP_DEFINE_CONST_FUN_OBJ_2(powers_iterable_obj, powers_iterable);
+INSTRUMENT_WRAP_2(powers_iterable)
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(powers_iterable_obj, INSTRUMENT(powers_iterable));
 
 STATIC const mp_rom_map_elem_t returniterable_module_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_returniterable) },
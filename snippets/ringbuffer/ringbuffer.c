@@ -0,0 +1,191 @@
+/*
+ * This file is part of the micropython-usermod project, 
+ *
+ * https://github.com/v923z/micropython-usermod
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020 Zoltán Vörös
+*/
+    
+#include <string.h>
+#include "py/obj.h"
+#include "py/runtime.h"
+#include "ringbuffer.h"
+#include "instrument.h"
+
+#define RINGBUFFER_LOAD(ptr) __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#define RINGBUFFER_STORE(ptr, value) __atomic_store_n((ptr), (value), __ATOMIC_RELEASE)
+
+// Copies at most len samples into the buffer, and returns the number of samples copied.
+// The samples that do not fit are dropped, and counted as overruns.
+size_t ringbuffer_put(ringbuffer_obj_t *self, const uint16_t *data, size_t len) {
+    size_t head = __atomic_load_n(&self->head, __ATOMIC_RELAXED);
+    size_t tail = RINGBUFFER_LOAD(&self->tail);
+    size_t capacity = self->mask + 1;
+    size_t space = capacity - (head - tail);
+    size_t n = len < space ? len : space;
+    size_t start = head & self->mask;
+    size_t first = n < capacity - start ? n : capacity - start;
+    memcpy(self->elements + start, data, first * sizeof(uint16_t));
+    memcpy(self->elements, data + first, (n - first) * sizeof(uint16_t));
+    if(n < len) {
+        __atomic_store_n(&self->overruns, self->overruns + (len - n), __ATOMIC_RELAXED);
+    }
+    // the samples have to be in place, before the consumer can see the new head
+    RINGBUFFER_STORE(&self->head, head + n);
+    return n;
+}
+
+// Copies at most len samples out of the buffer, and returns the number of samples copied
+size_t ringbuffer_get(ringbuffer_obj_t *self, uint16_t *data, size_t len) {
+    size_t tail = __atomic_load_n(&self->tail, __ATOMIC_RELAXED);
+    size_t head = RINGBUFFER_LOAD(&self->head);
+    size_t capacity = self->mask + 1;
+    size_t available = head - tail;
+    size_t n = len < available ? len : available;
+    size_t start = tail & self->mask;
+    size_t first = n < capacity - start ? n : capacity - start;
+    memcpy(data, self->elements + start, first * sizeof(uint16_t));
+    memcpy(data + first, self->elements, (n - first) * sizeof(uint16_t));
+    // the samples have to be read out, before the producer may overwrite them
+    RINGBUFFER_STORE(&self->tail, tail + n);
+    return n;
+}
+
+STATIC void ringbuffer_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t kind) {
+    (void)kind;
+    ringbuffer_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    size_t len = RINGBUFFER_LOAD(&self->head) - RINGBUFFER_LOAD(&self->tail);
+    mp_printf(print, "ringbuffer(%u), %u samples, %u overruns", (unsigned)(self->mask + 1), (unsigned)len,
+                (unsigned)__atomic_load_n(&self->overruns, __ATOMIC_RELAXED));
+}
+
+// ringbuffer(capacity), where capacity is a power of two
+STATIC mp_obj_t ringbuffer_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    mp_arg_check_num(n_args, n_kw, 1, 1, true);
+    mp_int_t capacity = mp_obj_get_int(args[0]);
+    if((capacity < 1) || ((capacity & (capacity - 1)) != 0)) {
+        mp_raise_ValueError("capacity must be a power of two");
+    }
+    ringbuffer_obj_t *self = m_new_obj(ringbuffer_obj_t);
+    self->base.type = &ringbuffer_type;
+    self->elements = m_new(uint16_t, capacity);
+    self->mask = capacity - 1;
+    self->head = 0;
+    self->tail = 0;
+    self->overruns = 0;
+    return MP_OBJ_FROM_PTR(self);
+}
+
+// put(samples)
+//
+// samples is a single integer in [0, 65535], or an array of type 'H'. Returns the number of samples stored;
+// the rest is dropped, and counted as overruns. Should be called by the producer only.
+STATIC mp_obj_t ringbuffer_put_method(mp_obj_t self_in, mp_obj_t samples) {
+    ringbuffer_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if(mp_obj_is_int(samples)) {
+        // an array of type 'H' can't hold anything else, and neither can a single sample
+        mp_int_t value = mp_obj_get_int(samples);
+        if((value < 0) || (value > UINT16_MAX)) {
+            mp_raise_ValueError("sample must be between 0 and 65535");
+        }
+        uint16_t sample = (uint16_t)value;
+        return MP_OBJ_NEW_SMALL_INT(ringbuffer_put(self, &sample, 1));
+    }
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(samples, &bufinfo, MP_BUFFER_READ);
+    if(bufinfo.typecode != 'H') {
+        mp_raise_TypeError("samples must be an array of type 'H'");
+    }
+    return mp_obj_new_int_from_uint(ringbuffer_put(self, bufinfo.buf, bufinfo.len / sizeof(uint16_t)));
+}
+
+INSTRUMENT_WRAP_2(ringbuffer_put_method)
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(ringbuffer_put_obj, INSTRUMENT(ringbuffer_put_method));
+
+// get(buffer)
+//
+// Fills the array of type 'H' with as many samples as are available, without waiting, and
+// returns their number. Should be called by the consumer only.
+STATIC mp_obj_t ringbuffer_get_method(mp_obj_t self_in, mp_obj_t buffer) {
+    ringbuffer_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(buffer, &bufinfo, MP_BUFFER_WRITE);
+    if(bufinfo.typecode != 'H') {
+        mp_raise_TypeError("buffer must be an array of type 'H'");
+    }
+    return mp_obj_new_int_from_uint(ringbuffer_get(self, bufinfo.buf, bufinfo.len / sizeof(uint16_t)));
+}
+
+INSTRUMENT_WRAP_2(ringbuffer_get_method)
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(ringbuffer_get_obj, INSTRUMENT(ringbuffer_get_method));
+
+// Drops all samples that are in the buffer; this is a consumer operation
+STATIC mp_obj_t ringbuffer_clear(mp_obj_t self_in) {
+    ringbuffer_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    RINGBUFFER_STORE(&self->tail, RINGBUFFER_LOAD(&self->head));
+    return mp_const_none;
+}
+
+INSTRUMENT_WRAP_1(ringbuffer_clear)
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(ringbuffer_clear_obj, INSTRUMENT(ringbuffer_clear));
+
+STATIC mp_obj_t ringbuffer_capacity(mp_obj_t self_in) {
+    ringbuffer_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    return mp_obj_new_int_from_uint(self->mask + 1);
+}
+
+INSTRUMENT_WRAP_1(ringbuffer_capacity)
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(ringbuffer_capacity_obj, INSTRUMENT(ringbuffer_capacity));
+
+// Returns the number of samples dropped since the buffer was created
+STATIC mp_obj_t ringbuffer_overruns(mp_obj_t self_in) {
+    ringbuffer_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    return mp_obj_new_int_from_uint(__atomic_load_n(&self->overruns, __ATOMIC_RELAXED));
+}
+
+INSTRUMENT_WRAP_1(ringbuffer_overruns)
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(ringbuffer_overruns_obj, INSTRUMENT(ringbuffer_overruns));
+
+STATIC mp_obj_t ringbuffer_unary_op(mp_unary_op_t op, mp_obj_t self_in) {
+    ringbuffer_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    size_t len = RINGBUFFER_LOAD(&self->head) - RINGBUFFER_LOAD(&self->tail);
+    switch (op) {
+        case MP_UNARY_OP_BOOL: return mp_obj_new_bool(len != 0);
+        case MP_UNARY_OP_LEN: return mp_obj_new_int_from_uint(len);
+        default: return MP_OBJ_NULL; // operator not supported
+    }
+}
+
+STATIC const mp_rom_map_elem_t ringbuffer_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_put), MP_ROM_PTR(&ringbuffer_put_obj) },
+    { MP_ROM_QSTR(MP_QSTR_get), MP_ROM_PTR(&ringbuffer_get_obj) },
+    { MP_ROM_QSTR(MP_QSTR_clear), MP_ROM_PTR(&ringbuffer_clear_obj) },
+    { MP_ROM_QSTR(MP_QSTR_capacity), MP_ROM_PTR(&ringbuffer_capacity_obj) },
+    { MP_ROM_QSTR(MP_QSTR_overruns), MP_ROM_PTR(&ringbuffer_overruns_obj) },
+};
+
+STATIC MP_DEFINE_CONST_DICT(ringbuffer_locals_dict, ringbuffer_locals_dict_table);
+
+const mp_obj_type_t ringbuffer_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_ringbuffer,
+    .print = ringbuffer_print,
+    .make_new = ringbuffer_make_new,
+    .unary_op = ringbuffer_unary_op,
+    .locals_dict = (mp_obj_dict_t*)&ringbuffer_locals_dict,
+};
+
+STATIC const mp_rom_map_elem_t ringbuffer_module_globals_table[] = {
+    { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_ringbuffer) },
+    { MP_ROM_QSTR(MP_QSTR_ringbuffer), MP_ROM_PTR(&ringbuffer_type) },
+};
+STATIC MP_DEFINE_CONST_DICT(ringbuffer_module_globals, ringbuffer_module_globals_table);
+
+const mp_obj_module_t ringbuffer_user_cmodule = {
+    .base = { &mp_type_module },
+    .globals = (mp_obj_dict_t*)&ringbuffer_module_globals,
+};
+
+MP_REGISTER_MODULE(MP_QSTR_ringbuffer, ringbuffer_user_cmodule, MODULE_RINGBUFFER_ENABLED);
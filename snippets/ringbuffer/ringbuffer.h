@@ -0,0 +1,39 @@
+/*
+ * This file is part of the micropython-usermod project, 
+ *
+ * https://github.com/v923z/micropython-usermod
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020 Zoltán Vörös
+*/
+    
+#ifndef _RINGBUFFER_H_
+#define _RINGBUFFER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "py/obj.h"
+
+// A single-producer, single-consumer ring buffer of 16-bit samples. Only the producer
+// writes head and overruns, and only the consumer writes tail, so neither side needs
+// a lock: the indices are published with release, and read with acquire semantics.
+// The indices run freely, and are reduced modulo the capacity, which is a power of two.
+typedef struct _ringbuffer_obj_t {
+    mp_obj_base_t base;
+    uint16_t *elements;
+    size_t mask; // the capacity less one
+    size_t head; // the number of samples written so far
+    size_t tail; // the number of samples read so far
+    size_t overruns; // the number of samples dropped, because the buffer was full
+} ringbuffer_obj_t;
+
+extern const mp_obj_type_t ringbuffer_type;
+
+// The C interface for producers outside of python, e.g., an interrupt handler, or a
+// thread on the unix port. Neither function allocates, or raises an exception; the
+// ring buffer must be kept alive by a reference from python.
+size_t ringbuffer_put(ringbuffer_obj_t *, const uint16_t *, size_t );
+size_t ringbuffer_get(ringbuffer_obj_t *, uint16_t *, size_t );
+
+#endif
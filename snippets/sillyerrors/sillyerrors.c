@@ -12,6 +12,7 @@
 #include "py/builtin.h"
 #include "py/runtime.h"
 #include <stdlib.h>
+#include "instrument.h"
 
 STATIC mp_obj_t mean_function(mp_obj_t error_code) {
     int e = mp_obj_get_int(error_code);
@@ -34,7 +35,8 @@ STATIC mp_obj_t mean_function(mp_obj_t error_code) {
     return mp_const_false;
 }
 
-STATIC MP_DEFINE_CONST_FUN_OBJ_1(mean_function_obj, mean_function);
+INSTRUMENT_WRAP_1(mean_function)
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(mean_function_obj, INSTRUMENT(mean_function));
 
 STATIC const mp_rom_map_elem_t sillyerrors_module_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_sillyerrors) },
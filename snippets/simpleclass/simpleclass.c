@@ -11,6 +11,7 @@
 #include <stdio.h>
 #include "py/runtime.h"
 #include "py/obj.h"
+#include "instrument.h"
 
 typedef struct _simpleclass_myclass_obj_t {
     mp_obj_base_t base;
@@ -45,7 +46,8 @@ STATIC mp_obj_t myclass_sum(mp_obj_t self_in) {
     return mp_obj_new_int(self->a + self->b);
 }
 
-MP_DEFINE_CONST_FUN_OBJ_1(myclass_sum_obj, myclass_sum);
+INSTRUMENT_WRAP_1(myclass_sum)
+MP_DEFINE_CONST_FUN_OBJ_1(myclass_sum_obj, INSTRUMENT(myclass_sum));
 
 STATIC const mp_rom_map_elem_t myclass_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_mysum), MP_ROM_PTR(&myclass_sum_obj) },
@@ -67,7 +69,8 @@ STATIC mp_obj_t simpleclass_add(const mp_obj_t o_in) {
     return mp_obj_new_int(class_instance->a + class_instance->b);
 }
 
-MP_DEFINE_CONST_FUN_OBJ_1(simpleclass_add_obj, simpleclass_add);
+INSTRUMENT_WRAP_1(simpleclass_add)
+MP_DEFINE_CONST_FUN_OBJ_1(simpleclass_add_obj, INSTRUMENT(simpleclass_add));
 
 STATIC const mp_map_elem_t simpleclass_globals_table[] = {
     { MP_OBJ_NEW_QSTR(MP_QSTR___name__), MP_OBJ_NEW_QSTR(MP_QSTR_simpleclass) },
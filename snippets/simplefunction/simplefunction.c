@@ -10,6 +10,7 @@
     
 #include "py/obj.h"
 #include "py/runtime.h"
+#include "instrument.h"
 
 STATIC mp_obj_t simplefunction_add_ints(mp_obj_t a_obj, mp_obj_t b_obj) {
     int a = mp_obj_get_int(a_obj);
@@ -17,7 +18,8 @@ STATIC mp_obj_t simplefunction_add_ints(mp_obj_t a_obj, mp_obj_t b_obj) {
     return mp_obj_new_int(a + b);
 }
 
-STATIC MP_DEFINE_CONST_FUN_OBJ_2(simplefunction_add_ints_obj, simplefunction_add_ints);
+INSTRUMENT_WRAP_2(simplefunction_add_ints)
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(simplefunction_add_ints_obj, INSTRUMENT(simplefunction_add_ints));
 
 STATIC const mp_rom_map_elem_t simplefunction_module_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_simplefunction) },
@@ -9,8 +9,13 @@
 */
     
 #include <stdlib.h>
+#include <string.h>
 #include "py/obj.h"
 #include "py/runtime.h"
+#include "py/binary.h"
+#include "uint16kernels.h"
+#include "byteorder.h"
+#include "instrument.h"
 
 typedef struct _sliceitarray_obj_t {
     mp_obj_base_t base;
@@ -82,18 +87,208 @@ STATIC mp_obj_t sliceitarray_subscr(mp_obj_t self_in, mp_obj_t index, mp_obj_t v
     return mp_const_none;
 }
 
+// Sorting and searching; the kernels in uint16kernels.h work on the raw elements, and allocate nothing but scratch memory
+
+STATIC mp_obj_t sliceitarray_sort(mp_obj_t self_in) {
+    sliceitarray_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    uint16kernels_sort(self->elements, self->len);
+    return mp_const_none;
+}
+
+INSTRUMENT_WRAP_1(sliceitarray_sort)
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(sliceitarray_sort_obj, INSTRUMENT(sliceitarray_sort));
+
+STATIC mp_obj_t sliceitarray_argsort(mp_obj_t self_in) {
+    sliceitarray_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    sliceitarray_obj_t *res = create_new_sliceitarray(self->len);
+    uint16kernels_argsort(self->elements, res->elements, self->len);
+    return MP_OBJ_FROM_PTR(res);
+}
+
+INSTRUMENT_WRAP_1(sliceitarray_argsort)
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(sliceitarray_argsort_obj, INSTRUMENT(sliceitarray_argsort));
+
+STATIC mp_obj_t sliceitarray_searchsorted(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_value, MP_ARG_REQUIRED | MP_ARG_INT, {.u_int = 0} },
+        { MP_QSTR_right, MP_ARG_KW_ONLY | MP_ARG_BOOL, {.u_bool = false} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+    sliceitarray_obj_t *self = MP_OBJ_TO_PTR(pos_args[0]);
+    return mp_obj_new_int_from_uint(uint16kernels_bisect(self->elements, self->len, args[0].u_int, args[1].u_bool));
+}
+
+INSTRUMENT_WRAP_KW(sliceitarray_searchsorted)
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(sliceitarray_searchsorted_obj, 2, INSTRUMENT(sliceitarray_searchsorted));
+
+// Returns the distinct values in ascending order; the array itself is left untouched
+STATIC mp_obj_t sliceitarray_unique(mp_obj_t self_in) {
+    sliceitarray_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    const uint16_t *sorted;
+    void *work = uint16kernels_sorted(self->elements, self->len, &sorted);
+    sliceitarray_obj_t *res = create_new_sliceitarray(uint16kernels_unique(sorted, self->len, NULL));
+    uint16kernels_unique(sorted, self->len, res->elements);
+    free(work);
+    return MP_OBJ_FROM_PTR(res);
+}
+
+INSTRUMENT_WRAP_1(sliceitarray_unique)
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(sliceitarray_unique_obj, INSTRUMENT(sliceitarray_unique));
+
+// Binning; the counts go into a caller-supplied array of 32-bit integers ('I', or 'i'), to which they are
+// added, so that a histogram can be accumulated over several arrays. The counts have to be zeroed by the caller.
+
+// histogram(counts, start=0, width=1)
+STATIC mp_obj_t sliceitarray_histogram(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_counts, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_rom_obj = MP_ROM_NONE } },
+        { MP_QSTR_start, MP_ARG_INT, {.u_int = 0 } },
+        { MP_QSTR_width, MP_ARG_INT, {.u_int = 1 } },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+    sliceitarray_obj_t *self = MP_OBJ_TO_PTR(pos_args[0]);
+    if(args[2].u_int < 1) {
+        mp_raise_ValueError("width must be positive");
+    }
+    size_t nbins;
+    uint32_t *counts = uint16kernels_get_counts(args[0].u_obj, &nbins);
+    return mp_obj_new_int_from_uint(uint16kernels_histogram(self->elements, self->len, counts, nbins, args[1].u_int, args[2].u_int));
+}
+
+INSTRUMENT_WRAP_KW(sliceitarray_histogram)
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(sliceitarray_histogram_obj, 2, INSTRUMENT(sliceitarray_histogram));
+
+// bucketize(edges, counts)
+//
+// edges is an ascending array of the same type, or an array of type 'H', and counts must have
+// len(edges) + 1 elements. counts[i] is incremented for each value v with edges[i-1] <= v < edges[i];
+// the first and the last bucket are open towards 0, and 65535, respectively.
+STATIC mp_obj_t sliceitarray_bucketize(mp_obj_t self_in, mp_obj_t edges_in, mp_obj_t counts_in) {
+    sliceitarray_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    const uint16_t *edges;
+    size_t nedges;
+    if(mp_obj_is_type(edges_in, &sliceiterable_array_type)) {
+        sliceitarray_obj_t *other = MP_OBJ_TO_PTR(edges_in);
+        edges = other->elements;
+        nedges = other->len;
+    } else {
+        mp_buffer_info_t bufinfo;
+        mp_get_buffer_raise(edges_in, &bufinfo, MP_BUFFER_READ);
+        if(bufinfo.typecode != 'H') {
+            mp_raise_TypeError("edges must be an array of type 'H'");
+        }
+        edges = bufinfo.buf;
+        nedges = bufinfo.len / sizeof(uint16_t);
+    }
+    if(!uint16kernels_is_sorted(edges, nedges)) {
+        mp_raise_ValueError("edges must be in ascending order");
+    }
+    size_t nbins;
+    uint32_t *counts = uint16kernels_get_counts(counts_in, &nbins);
+    if(nbins != nedges + 1) {
+        mp_raise_ValueError("counts must be one longer than edges");
+    }
+    uint16kernels_bucketize(self->elements, self->len, edges, nedges, counts);
+    return counts_in;
+}
+
+INSTRUMENT_WRAP_3(sliceitarray_bucketize)
+STATIC MP_DEFINE_CONST_FUN_OBJ_3(sliceitarray_bucketize_obj, INSTRUMENT(sliceitarray_bucketize));
+
+// cumulative(counts)
+//
+// Replaces the counts by their running totals, in place; the totals saturate at 2^32-1
+STATIC mp_obj_t sliceiterable_cumulative(mp_obj_t counts_in) {
+    size_t len;
+    uint32_t *counts = uint16kernels_get_counts(counts_in, &len);
+    uint16kernels_cumulative(counts, len);
+    return counts_in;
+}
+
+INSTRUMENT_WRAP_1(sliceiterable_cumulative)
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(sliceiterable_cumulative_obj, INSTRUMENT(sliceiterable_cumulative));
+
+// Binary serialisation; the elements are written as 16-bit unsigned integers in the requested byte order
+
+STATIC mp_obj_t sliceitarray_pack_into(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_buffer, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_rom_obj = MP_ROM_NONE } },
+        { MP_QSTR_offset, MP_ARG_INT, {.u_int = 0 } },
+        { MP_QSTR_byteorder, MP_ARG_OBJ, {.u_rom_obj = MP_ROM_QSTR(MP_QSTR_little) } },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+    sliceitarray_obj_t *self = MP_OBJ_TO_PTR(pos_args[0]);
+    size_t nbytes = self->len * sizeof(uint16_t);
+    byte *dest = byteorder_buffer_at(args[0].u_obj, args[1].u_int, nbytes, MP_BUFFER_WRITE);
+    byteorder_store_uint16(dest, self->elements, self->len, byteorder_big_endian(args[2].u_obj));
+    return mp_obj_new_int_from_uint(args[1].u_int + nbytes);
+}
+
+INSTRUMENT_WRAP_KW(sliceitarray_pack_into)
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(sliceitarray_pack_into_obj, 2, INSTRUMENT(sliceitarray_pack_into));
+
+STATIC mp_obj_t sliceitarray_to_bytes(size_t n_args, const mp_obj_t *args) {
+    sliceitarray_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    bool big_endian = n_args > 1 ? byteorder_big_endian(args[1]) : false;
+    // the bytes object is created uninitialised, and filled in place
+    vstr_t vstr;
+    vstr_init_len(&vstr, self->len * sizeof(uint16_t));
+    byteorder_store_uint16((byte *)vstr.buf, self->elements, self->len, big_endian);
+    return mp_obj_new_str_from_vstr(&mp_type_bytes, &vstr);
+}
+
+INSTRUMENT_WRAP_VAR(sliceitarray_to_bytes)
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(sliceitarray_to_bytes_obj, 1, 2, INSTRUMENT(sliceitarray_to_bytes));
+
+STATIC mp_obj_t sliceiterable_from_bytes(size_t n_args, const mp_obj_t *args) {
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(args[0], &bufinfo, MP_BUFFER_READ);
+    bool big_endian = n_args > 1 ? byteorder_big_endian(args[1]) : false;
+    size_t len = bufinfo.len / sizeof(uint16_t);
+    if(len > UINT16_MAX) {
+        mp_raise_ValueError("buffer is too long");
+    }
+    sliceitarray_obj_t *self = create_new_sliceitarray(len);
+    byteorder_load_uint16(self->elements, bufinfo.buf, len, big_endian);
+    return MP_OBJ_FROM_PTR(self);
+}
+
+INSTRUMENT_WRAP_VAR(sliceiterable_from_bytes)
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(sliceiterable_from_bytes_obj, 1, 2, INSTRUMENT(sliceiterable_from_bytes));
+
+STATIC const mp_rom_map_elem_t sliceitarray_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_sort), MP_ROM_PTR(&sliceitarray_sort_obj) },
+    { MP_ROM_QSTR(MP_QSTR_argsort), MP_ROM_PTR(&sliceitarray_argsort_obj) },
+    { MP_ROM_QSTR(MP_QSTR_searchsorted), MP_ROM_PTR(&sliceitarray_searchsorted_obj) },
+    { MP_ROM_QSTR(MP_QSTR_unique), MP_ROM_PTR(&sliceitarray_unique_obj) },
+    { MP_ROM_QSTR(MP_QSTR_histogram), MP_ROM_PTR(&sliceitarray_histogram_obj) },
+    { MP_ROM_QSTR(MP_QSTR_bucketize), MP_ROM_PTR(&sliceitarray_bucketize_obj) },
+    { MP_ROM_QSTR(MP_QSTR_to_bytes), MP_ROM_PTR(&sliceitarray_to_bytes_obj) },
+    { MP_ROM_QSTR(MP_QSTR_pack_into), MP_ROM_PTR(&sliceitarray_pack_into_obj) },
+};
+
+STATIC MP_DEFINE_CONST_DICT(sliceitarray_locals_dict, sliceitarray_locals_dict_table);
+
+INSTRUMENT_WRAP_3(sliceitarray_subscr)
+
 const mp_obj_type_t sliceiterable_array_type = {
     { &mp_type_type },
     .name = MP_QSTR_sliceitarray,
     .print = sliceitarray_print,
     .make_new = sliceitarray_make_new,
     .getiter = sliceitarray_getiter,
-    .subscr = sliceitarray_subscr,
+    .subscr = INSTRUMENT(sliceitarray_subscr),
+    .locals_dict = (mp_obj_dict_t*)&sliceitarray_locals_dict,
 };
 
 STATIC const mp_rom_map_elem_t sliceiterable_module_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_sliceiterable) },
     { MP_OBJ_NEW_QSTR(MP_QSTR_square), (mp_obj_t)&sliceiterable_array_type },
+    { MP_ROM_QSTR(MP_QSTR_from_bytes), MP_ROM_PTR(&sliceiterable_from_bytes_obj) },
+    { MP_ROM_QSTR(MP_QSTR_cumulative), MP_ROM_PTR(&sliceiterable_cumulative_obj) },
 };
 STATIC MP_DEFINE_CONST_DICT(sliceiterable_module_globals, sliceiterable_module_globals_table);
 
@@ -9,9 +9,14 @@
 */
     
 #include <stdio.h>
+#include <string.h>
 #include "py/runtime.h"
 #include "py/obj.h"
 #include "py/binary.h"
+#include "byteorder.h"
+#include "py/objlist.h"
+#include "py/smallint.h"
+#include "instrument.h"
 
 typedef struct _specialclass_myclass_obj_t {
     mp_obj_base_t base;
@@ -31,7 +36,30 @@ STATIC void myclass_print(const mp_print_t *print, mp_obj_t self_in, mp_print_ki
     mp_print_str(print, ")");
 }
 
+// Instances with 0 <= a, b < SPECIALCLASS_INTERN_SIZE are not allocated on the heap: they are shared,
+// and taken from a static table. This is safe, because the instances can't be modified from python.
+// Set SPECIALCLASS_INTERN_SIZE to 0 to switch the cache off.
+#ifndef SPECIALCLASS_INTERN_SIZE
+#define SPECIALCLASS_INTERN_SIZE (8)
+#endif
+
+#if SPECIALCLASS_INTERN_SIZE
+STATIC specialclass_myclass_obj_t specialclass_intern_table[SPECIALCLASS_INTERN_SIZE][SPECIALCLASS_INTERN_SIZE];
+#endif
+
 mp_obj_t create_new_myclass(uint16_t a, uint16_t b) {
+#if SPECIALCLASS_INTERN_SIZE
+    // negative values wrap around, and end up outside the table
+    if((a < SPECIALCLASS_INTERN_SIZE) && (b < SPECIALCLASS_INTERN_SIZE)) {
+        specialclass_myclass_obj_t *out = &specialclass_intern_table[a][b];
+        if(out->base.type == NULL) { // the entry is filled in, when it is first used
+            out->base.type = &specialclass_myclass_type;
+            out->a = a;
+            out->b = b;
+        }
+        return MP_OBJ_FROM_PTR(out);
+    }
+#endif
     specialclass_myclass_obj_t *out = m_new_obj(specialclass_myclass_obj_t);
     out->base.type = &specialclass_myclass_type;
     out->a = a;
@@ -44,7 +72,116 @@ STATIC mp_obj_t myclass_make_new(const mp_obj_type_t *type, size_t n_args, size_
     return create_new_myclass(mp_obj_get_int(args[0]), mp_obj_get_int(args[1]));
 }
 
+// Binary serialisation: an instance is packed as two signed 16-bit integers
+#define MYCLASS_PACKED_SIZE (2 * sizeof(int16_t))
+
+STATIC void myclass_pack(mp_obj_t o_in, byte *dest, bool big_endian) {
+    if(!mp_obj_is_type(o_in, &specialclass_myclass_type)) {
+        mp_raise_TypeError("argument is not a myclass instance");
+    }
+    specialclass_myclass_obj_t *self = MP_OBJ_TO_PTR(o_in);
+    mp_binary_set_int(sizeof(int16_t), big_endian, dest, (uint16_t)self->a);
+    mp_binary_set_int(sizeof(int16_t), big_endian, dest + sizeof(int16_t), (uint16_t)self->b);
+}
+
+STATIC mp_obj_t myclass_unpack(const byte *src, bool big_endian) {
+    int16_t a = mp_binary_get_int(sizeof(int16_t), true, big_endian, src);
+    int16_t b = mp_binary_get_int(sizeof(int16_t), true, big_endian, src + sizeof(int16_t));
+    return create_new_myclass(a, b);
+}
+
+STATIC mp_obj_t myclass_to_bytes(size_t n_args, const mp_obj_t *args) {
+    bool big_endian = n_args > 1 ? byteorder_big_endian(args[1]) : false;
+    byte buffer[MYCLASS_PACKED_SIZE];
+    myclass_pack(args[0], buffer, big_endian);
+    return mp_obj_new_bytes(buffer, MYCLASS_PACKED_SIZE);
+}
+
+INSTRUMENT_WRAP_VAR(myclass_to_bytes)
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(myclass_to_bytes_obj, 1, 2, INSTRUMENT(myclass_to_bytes));
+
+// m.pack_into(buffer, offset=0, byteorder='little') writes a single instance, and returns the offset after it
+STATIC mp_obj_t myclass_pack_into(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_buffer, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_rom_obj = MP_ROM_NONE } },
+        { MP_QSTR_offset, MP_ARG_INT, {.u_int = 0 } },
+        { MP_QSTR_byteorder, MP_ARG_OBJ, {.u_rom_obj = MP_ROM_QSTR(MP_QSTR_little) } },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+    byte *dest = byteorder_buffer_at(args[0].u_obj, args[1].u_int, MYCLASS_PACKED_SIZE, MP_BUFFER_WRITE);
+    myclass_pack(pos_args[0], dest, byteorder_big_endian(args[2].u_obj));
+    return mp_obj_new_int(args[1].u_int + MYCLASS_PACKED_SIZE);
+}
+
+INSTRUMENT_WRAP_KW(myclass_pack_into)
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(myclass_pack_into_obj, 2, INSTRUMENT(myclass_pack_into));
+
+// specialclass.pack_into(buffer, offset, objects, byteorder='little') writes a whole sequence of instances
+// back to back in a single call, and returns the offset after the last one
+STATIC mp_obj_t specialclass_pack_into(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_buffer, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_rom_obj = MP_ROM_NONE } },
+        { MP_QSTR_offset, MP_ARG_REQUIRED | MP_ARG_INT, {.u_int = 0 } },
+        { MP_QSTR_objects, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_rom_obj = MP_ROM_NONE } },
+        { MP_QSTR_byteorder, MP_ARG_OBJ, {.u_rom_obj = MP_ROM_QSTR(MP_QSTR_little) } },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+    bool big_endian = byteorder_big_endian(args[3].u_obj);
+    size_t len = mp_obj_get_int(mp_obj_len(args[2].u_obj));
+    // the bounds are checked once for the whole sequence
+    byte *dest = byteorder_buffer_at(args[0].u_obj, args[1].u_int, len * MYCLASS_PACKED_SIZE, MP_BUFFER_WRITE);
+    mp_obj_iter_buf_t iter_buf;
+    mp_obj_t item, iterable = mp_getiter(args[2].u_obj, &iter_buf);
+    for(size_t i=0; (i < len) && ((item = mp_iternext(iterable)) != MP_OBJ_STOP_ITERATION); i++) {
+        myclass_pack(item, dest, big_endian);
+        dest += MYCLASS_PACKED_SIZE;
+    }
+    return mp_obj_new_int(args[1].u_int + len * MYCLASS_PACKED_SIZE);
+}
+
+INSTRUMENT_WRAP_KW(specialclass_pack_into)
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(specialclass_pack_into_obj, 3, INSTRUMENT(specialclass_pack_into));
+
+STATIC mp_obj_t specialclass_from_bytes(size_t n_args, const mp_obj_t *args) {
+    bool big_endian = n_args > 1 ? byteorder_big_endian(args[1]) : false;
+    return myclass_unpack(byteorder_buffer_at(args[0], 0, MYCLASS_PACKED_SIZE, MP_BUFFER_READ), big_endian);
+}
+
+INSTRUMENT_WRAP_VAR(specialclass_from_bytes)
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(specialclass_from_bytes_obj, 1, 2, INSTRUMENT(specialclass_from_bytes));
+
+// specialclass.unpack_from(buffer, offset=0, count=1, byteorder='little') returns a list of count instances
+STATIC mp_obj_t specialclass_unpack_from(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_buffer, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_rom_obj = MP_ROM_NONE } },
+        { MP_QSTR_offset, MP_ARG_INT, {.u_int = 0 } },
+        { MP_QSTR_count, MP_ARG_INT, {.u_int = 1 } },
+        { MP_QSTR_byteorder, MP_ARG_OBJ, {.u_rom_obj = MP_ROM_QSTR(MP_QSTR_little) } },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+    if(args[2].u_int < 0) {
+        mp_raise_ValueError("count must be non-negative");
+    }
+    size_t len = args[2].u_int;
+    bool big_endian = byteorder_big_endian(args[3].u_obj);
+    const byte *src = byteorder_buffer_at(args[0].u_obj, args[1].u_int, len * MYCLASS_PACKED_SIZE, MP_BUFFER_READ);
+    mp_obj_list_t *list = MP_OBJ_TO_PTR(mp_obj_new_list(len, NULL));
+    for(size_t i=0; i < len; i++) {
+        list->items[i] = myclass_unpack(src, big_endian);
+        src += MYCLASS_PACKED_SIZE;
+    }
+    return MP_OBJ_FROM_PTR(list);
+}
+
+INSTRUMENT_WRAP_KW(specialclass_unpack_from)
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(specialclass_unpack_from_obj, 1, INSTRUMENT(specialclass_unpack_from));
+
 STATIC const mp_rom_map_elem_t myclass_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_to_bytes), MP_ROM_PTR(&myclass_to_bytes_obj) },
+    { MP_ROM_QSTR(MP_QSTR_pack_into), MP_ROM_PTR(&myclass_pack_into_obj) },
 };
 
 STATIC MP_DEFINE_CONST_DICT(myclass_locals_dict, myclass_locals_dict_table);
@@ -54,11 +191,17 @@ STATIC mp_obj_t specialclass_unary_op(mp_unary_op_t op, mp_obj_t self_in) {
     switch (op) {
         case MP_UNARY_OP_BOOL: return mp_obj_new_bool((self->a > 0) && (self->b > 0));
         case MP_UNARY_OP_LEN: return mp_obj_new_int(2);
+        // equal instances have equal hashes, hence they can be used as keys in dictionaries, and in sets
+        case MP_UNARY_OP_HASH: return MP_OBJ_NEW_SMALL_INT((((mp_uint_t)(uint16_t)self->a << 16) | (uint16_t)self->b) & MP_SMALL_INT_POSITIVE_MASK);
         default: return MP_OBJ_NULL; // operator not supported
     }
 }
 
 STATIC mp_obj_t specialclass_binary_op(mp_binary_op_t op, mp_obj_t lhs, mp_obj_t rhs) {
+    // a dictionary lookup might compare us to a key of any type
+    if(!mp_obj_is_type(rhs, &specialclass_myclass_type)) {
+        return MP_OBJ_NULL; // operator not supported
+    }
     specialclass_myclass_obj_t *left_hand_side = MP_OBJ_TO_PTR(lhs);
     specialclass_myclass_obj_t *right_hand_side = MP_OBJ_TO_PTR(rhs);
     switch (op) {
@@ -73,19 +216,24 @@ STATIC mp_obj_t specialclass_binary_op(mp_binary_op_t op, mp_obj_t lhs, mp_obj_t
     }
 }
 
+INSTRUMENT_WRAP_BINARY_OP(specialclass_binary_op)
+
 const mp_obj_type_t specialclass_myclass_type = {
     { &mp_type_type },
     .name = MP_QSTR_specialclass,
     .print = myclass_print,
     .make_new = myclass_make_new,
     .unary_op = specialclass_unary_op, 
-    .binary_op = specialclass_binary_op,
+    .binary_op = INSTRUMENT(specialclass_binary_op),
     .locals_dict = (mp_obj_dict_t*)&myclass_locals_dict,
 };
 
 STATIC const mp_map_elem_t specialclass_globals_table[] = {
     { MP_OBJ_NEW_QSTR(MP_QSTR___name__), MP_OBJ_NEW_QSTR(MP_QSTR_specialclass) },
     { MP_OBJ_NEW_QSTR(MP_QSTR_myclass), (mp_obj_t)&specialclass_myclass_type },	
+    { MP_OBJ_NEW_QSTR(MP_QSTR_pack_into), (mp_obj_t)&specialclass_pack_into_obj },
+    { MP_OBJ_NEW_QSTR(MP_QSTR_from_bytes), (mp_obj_t)&specialclass_from_bytes_obj },
+    { MP_OBJ_NEW_QSTR(MP_QSTR_unpack_from), (mp_obj_t)&specialclass_unpack_from_obj },
 };
 
 STATIC MP_DEFINE_CONST_DICT (
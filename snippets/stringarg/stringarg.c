@@ -12,6 +12,7 @@
 #include "py/obj.h"
 #include "py/runtime.h"
 #include "py/objstr.h"
+#include "instrument.h"
 
 #define byteswap(a,b) char tmp = a; a = b; b = tmp; 
 
@@ -27,7 +28,8 @@ STATIC mp_obj_t stringarg_function(const mp_obj_t o_in) {
     return mp_obj_new_str(out_str, str_len);
 } 
 
-STATIC MP_DEFINE_CONST_FUN_OBJ_1(stringarg_function_obj, stringarg_function);
+INSTRUMENT_WRAP_1(stringarg_function)
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(stringarg_function_obj, INSTRUMENT(stringarg_function));
 
 STATIC const mp_rom_map_elem_t stringarg_module_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_stringarg) },
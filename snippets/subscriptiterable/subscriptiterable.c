@@ -9,24 +9,81 @@
 */
     
 #include <stdlib.h>
+#include <string.h>
 #include "py/obj.h"
 #include "py/runtime.h"
+#include "py/binary.h"
+#include "uint16kernels.h"
+#include "byteorder.h"
+#include "record.h"
+#include "instrument.h"
+
+// Memory-mapped files are available only on the unix port
+#ifndef SUBSCRIPTITERABLE_USE_MMAP
+#if defined(__unix__)
+#define SUBSCRIPTITERABLE_USE_MMAP (1)
+#else
+#define SUBSCRIPTITERABLE_USE_MMAP (0)
+#endif
+#endif
+
+#if SUBSCRIPTITERABLE_USE_MMAP
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 typedef struct _subitarray_obj_t {
     mp_obj_base_t base;
     mp_fun_1_t iternext;
-    uint16_t *elements;
+    uint16_t *elements; // can be NULL for an empty array
     size_t len;
+    bool closed;
+    char mode; // 'r': read-only, 'w': writable, 'c': copy-on-write
+    mp_obj_t owner; // the object, whose memory the elements are a view of, or MP_OBJ_NULL
+#if SUBSCRIPTITERABLE_USE_MMAP
+    size_t map_len; // size of the mapping in bytes, 0, if the elements live on the heap
+#endif
+    uint32_t *dirty; // one bit per block, NULL, if the changes are not tracked
+    uint32_t *checksums; // the CRC32 and Adler-32 of each block at the last sync, interleaved
+    uint8_t block_shift; // a block is 2^block_shift elements long
 } subitarray_obj_t;
 
 const mp_obj_type_t subiterable_array_type;
 mp_obj_t mp_obj_new_subitarray_iterator(mp_obj_t , size_t , mp_obj_iter_buf_t *);
+STATIC void subitarray_untrack(subitarray_obj_t *);
+
+// A bytearray, or an array can be resized, and then its data move, so a view can't hold on to the
+// buffer: the elements, and the length are fetched from the owner before each access.
+STATIC void subitarray_refresh(subitarray_obj_t *self) {
+    if(self->owner == MP_OBJ_NULL) {
+        return;
+    }
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(self->owner, &bufinfo, MP_BUFFER_READ);
+    if(((uintptr_t)bufinfo.buf & (sizeof(uint16_t) - 1)) != 0) {
+        mp_raise_ValueError("buffer is not aligned");
+    }
+    size_t len = bufinfo.len / sizeof(uint16_t);
+    if((len != self->len) && (self->dirty != NULL)) {
+        // the blocks no longer match the data, the tracking has to be started again
+        subitarray_untrack(self);
+    }
+    self->elements = (uint16_t *)bufinfo.buf;
+    self->len = len;
+}
 
 STATIC void subitarray_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t kind) {
     (void)kind;
     subitarray_obj_t *self = MP_OBJ_TO_PTR(self_in);
     mp_print_str(print, "subitarray: ");
-    uint16_t i;
+    subitarray_refresh(self);
+    if(self->len == 0) {
+        return;
+    }
+    size_t i;
     for(i=0; i < self->len-1; i++) {
         mp_obj_print_helper(print, mp_obj_new_int(self->elements[i]), PRINT_REPR);
         mp_print_str(print, ", ");
@@ -34,25 +91,450 @@ STATIC void subitarray_print(const mp_print_t *print, mp_obj_t self_in, mp_print
     mp_obj_print_helper(print, mp_obj_new_int(self->elements[i]), PRINT_REPR);
 }
 
+subitarray_obj_t *create_new_subitarray(size_t len) {
+    subitarray_obj_t *self = m_new_obj_with_finaliser(subitarray_obj_t);
+    self->base.type = &subiterable_array_type;
+    // the array stays closed, until the elements are allocated, so that the finaliser has nothing to free
+    self->elements = NULL;
+    self->len = 0;
+    self->closed = true;
+    self->mode = 'w';
+    self->owner = MP_OBJ_NULL;
+#if SUBSCRIPTITERABLE_USE_MMAP
+    self->map_len = 0;
+#endif
+    self->dirty = NULL;
+    if(len > 0) {
+        if(len > SIZE_MAX / sizeof(uint16_t)) {
+            m_malloc_fail(SIZE_MAX);
+        }
+        self->elements = malloc(len * sizeof(uint16_t));
+        if(self->elements == NULL) {
+            m_malloc_fail(len * sizeof(uint16_t));
+        }
+    }
+    self->len = len;
+    self->closed = false;
+    return self;
+}
+
 STATIC mp_obj_t subitarray_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
     mp_arg_check_num(n_args, n_kw, 1, 1, true);
-    subitarray_obj_t *self = m_new_obj(subitarray_obj_t);
+    subitarray_obj_t *self = create_new_subitarray(mp_obj_get_int(args[0]));
+    for(size_t i=0; i < self->len; i++) {
+        self->elements[i] = i*i;
+    }
+    return MP_OBJ_FROM_PTR(self);
+}
+
+STATIC void subitarray_check_open(subitarray_obj_t *self) {
+    if(self->closed) {
+        mp_raise_ValueError("array is closed");
+    }
+    subitarray_refresh(self);
+}
+
+STATIC void subitarray_check_writable(subitarray_obj_t *self) {
+    subitarray_check_open(self);
+    if(self->mode == 'r') {
+        mp_raise_TypeError("array is read-only");
+    }
+}
+
+// Change tracking: with track(), the array is divided into blocks, and each write through the
+// array (element and slice assignments, and sort()) sets the bit of the blocks that it touches.
+// Nothing else is done on a write. changes() recomputes the CRC32 and Adler-32 of the dirty blocks
+// only, and reports those, whose contents differ from the last sync, so that the cost of a sync
+// scales with the amount of data written, and not with the length of the array. Writes that
+// bypass the array, e.g., into the buffer of a view, or into a shared mapping by another
+// process, are not seen.
+
+#ifndef SUBITARRAY_BLOCK
+#define SUBITARRAY_BLOCK (256)
+#endif
+
+STATIC size_t subitarray_blocks(subitarray_obj_t *self) {
+    return (self->len + ((size_t)1 << self->block_shift) - 1) >> self->block_shift;
+}
+
+// Marks the blocks of the elements in [start, stop) as dirty; stop must be larger than start
+STATIC void subitarray_mark(subitarray_obj_t *self, size_t start, size_t stop) {
+    if(self->dirty == NULL) {
+        return;
+    }
+    size_t last = (stop - 1) >> self->block_shift;
+    for(size_t block = start >> self->block_shift; block <= last; block++) {
+        self->dirty[block >> 5] |= (uint32_t)1 << (block & 31);
+    }
+}
+
+// The checksums are those of the little-endian bytes, i.e., of the output of to_bytes(), so that
+// the host can check them with zlib.crc32, and zlib.adler32. The CRC table is by the nibble to save ROM.
+STATIC const uint32_t subitarray_crc_table[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+};
+
+STATIC uint32_t subitarray_crc32(const uint16_t *arr, size_t len) {
+    uint32_t crc = 0xFFFFFFFF;
+    for(size_t i=0; i < len; i++) {
+        crc ^= arr[i];
+        // two bytes, four nibbles
+        crc = (crc >> 4) ^ subitarray_crc_table[crc & 0x0F];
+        crc = (crc >> 4) ^ subitarray_crc_table[crc & 0x0F];
+        crc = (crc >> 4) ^ subitarray_crc_table[crc & 0x0F];
+        crc = (crc >> 4) ^ subitarray_crc_table[crc & 0x0F];
+    }
+    return ~crc;
+}
+
+#define SUBITARRAY_ADLER_BASE (65521)
+// the sums can't overflow within this many elements (5552 bytes), and are reduced only after them
+#define SUBITARRAY_ADLER_RUN (2776)
+
+STATIC uint32_t subitarray_adler32(const uint16_t *arr, size_t len) {
+    uint32_t a = 1, b = 0;
+    while(len > 0) {
+        size_t run = len < SUBITARRAY_ADLER_RUN ? len : SUBITARRAY_ADLER_RUN;
+        len -= run;
+        for(size_t i=0; i < run; i++) {
+            a += arr[i] & 0xFF;
+            b += a;
+            a += arr[i] >> 8;
+            b += a;
+        }
+        arr += run;
+        a %= SUBITARRAY_ADLER_BASE;
+        b %= SUBITARRAY_ADLER_BASE;
+    }
+    return (b << 16) | a;
+}
+
+STATIC void subitarray_untrack(subitarray_obj_t *self) {
+    free(self->dirty);
+    self->dirty = NULL;
+    self->checksums = NULL;
+}
+
+// track(block=256)
+//
+// Starts tracking the changes in blocks of block elements, which must be a power of two. The
+// current contents are taken as synced. With block=0, the tracking is stopped.
+STATIC mp_obj_t subitarray_track(size_t n_args, const mp_obj_t *args) {
+    subitarray_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    subitarray_check_open(self);
+    mp_int_t block = n_args > 1 ? mp_obj_get_int(args[1]) : SUBITARRAY_BLOCK;
+    if((block < 0) || ((block & (block - 1)) != 0)) {
+        mp_raise_ValueError("block must be a power of 2");
+    }
+    subitarray_untrack(self);
+    if(block == 0) {
+        return mp_const_none;
+    }
+    self->block_shift = 0;
+    while(((mp_int_t)1 << self->block_shift) < block) {
+        self->block_shift++;
+    }
+    size_t nblocks = subitarray_blocks(self);
+    size_t words = nblocks / 32 + 1;
+    size_t size = (words + 2 * nblocks) * sizeof(uint32_t);
+    uint32_t *dirty = malloc(size);
+    if(dirty == NULL) {
+        m_malloc_fail(size);
+    }
+    memset(dirty, 0, words * sizeof(uint32_t));
+    uint32_t *checksums = dirty + words;
+    for(size_t i=0; i < nblocks; i++) {
+        size_t start = i << self->block_shift;
+        size_t len = self->len - start < (size_t)block ? self->len - start : (size_t)block;
+        checksums[2*i] = subitarray_crc32(self->elements + start, len);
+        checksums[2*i+1] = subitarray_adler32(self->elements + start, len);
+    }
+    self->dirty = dirty;
+    self->checksums = checksums;
+    return mp_const_none;
+}
+
+INSTRUMENT_WRAP_VAR(subitarray_track)
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(subitarray_track_obj, 1, 2, INSTRUMENT(subitarray_track));
+
+STATIC const qstr subitarray_change_fields[] = { MP_QSTR_start, MP_QSTR_stop, MP_QSTR_crc32, MP_QSTR_adler32 };
+STATIC const record_type_t subitarray_change_type = RECORD_TYPE(MP_QSTR_change, subitarray_change_fields);
+
+// Returns a list of change(start, stop, crc32, adler32) records, one for each block that has been
+// modified since the last call, where start, and stop are indices of elements, and the checksums
+// are those of elements[start:stop]. The blocks are clean afterwards. A block that has been
+// written to, but holds the same data as before, is not reported. If the list can't be
+// allocated, the changed blocks are reported again by the next call.
+STATIC mp_obj_t subitarray_changes(mp_obj_t self_in) {
+    subitarray_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    subitarray_check_open(self);
+    if(self->dirty == NULL) {
+        mp_raise_ValueError("changes are not tracked");
+    }
+    mp_obj_t list = mp_obj_new_list(0, NULL);
+    size_t nblocks = subitarray_blocks(self);
+    for(size_t block=0; block < nblocks; block++) {
+        uint32_t *word = &self->dirty[block >> 5];
+        if(*word == 0) {
+            // skip the rest of the 32 blocks
+            block |= 31;
+            continue;
+        }
+        uint32_t bit = (uint32_t)1 << (block & 31);
+        if((*word & bit) == 0) {
+            continue;
+        }
+        size_t start = block << self->block_shift;
+        size_t stop = start + ((size_t)1 << self->block_shift);
+        if(stop > self->len) {
+            stop = self->len;
+        }
+        uint32_t crc = subitarray_crc32(self->elements + start, stop - start);
+        uint32_t adler = subitarray_adler32(self->elements + start, stop - start);
+        if((crc != self->checksums[2*block]) || (adler != self->checksums[2*block+1])) {
+            mp_obj_t items[4];
+            items[0] = mp_obj_new_int_from_uint(start);
+            items[1] = mp_obj_new_int_from_uint(stop);
+            items[2] = mp_obj_new_int_from_uint(crc);
+            items[3] = mp_obj_new_int_from_uint(adler);
+            mp_obj_list_append(list, record_new(&subitarray_change_type, items));
+            // the block stays dirty, and keeps the old checksums, until the whole list has been built,
+            // so that a failed allocation loses nothing
+            continue;
+        }
+        *word &= ~bit;
+    }
+    // nothing is allocated from here on: the reported blocks are marked as synced
+    size_t len;
+    mp_obj_t *records;
+    mp_obj_list_get(list, &len, &records);
+    for(size_t i=0; i < len; i++) {
+        mp_obj_tuple_t *record = MP_OBJ_TO_PTR(records[i]);
+        size_t block = (size_t)mp_obj_get_int(record->items[0]) >> self->block_shift;
+        self->checksums[2*block] = (uint32_t)mp_obj_int_get_truncated(record->items[2]);
+        self->checksums[2*block+1] = (uint32_t)mp_obj_int_get_truncated(record->items[3]);
+        self->dirty[block >> 5] &= ~((uint32_t)1 << (block & 31));
+    }
+    return list;
+}
+
+INSTRUMENT_WRAP_1(subitarray_changes)
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(subitarray_changes_obj, INSTRUMENT(subitarray_changes));
+
+#if SUBSCRIPTITERABLE_USE_MMAP
+// Maps the file read-only ('r'), shared read-write ('w'), or copy-on-write ('c').
+// Pages are brought in by the kernel only when they are first touched,
+// so that the size of the file is limited by the address space, and not by the RAM.
+STATIC mp_obj_t subscriptiterable_mmap(size_t n_args, const mp_obj_t *args) {
+    const char *filename = mp_obj_str_get_str(args[0]);
+    char mode = 'r';
+    if(n_args > 1) {
+        mode = *mp_obj_str_get_str(args[1]);
+    }
+    int flags, prot, share;
+    if(mode == 'r') {
+        flags = O_RDONLY;
+        prot = PROT_READ;
+        share = MAP_SHARED;
+    } else if(mode == 'w') {
+        flags = O_RDWR;
+        prot = PROT_READ | PROT_WRITE;
+        share = MAP_SHARED;
+    } else if(mode == 'c') {
+        flags = O_RDONLY;
+        prot = PROT_READ | PROT_WRITE;
+        share = MAP_PRIVATE;
+    } else {
+        mp_raise_ValueError("mode must be 'r', 'w', or 'c'");
+    }
+
+    // allocate the object first, so that a failing allocation cannot leak the descriptor or the mapping
+    subitarray_obj_t *self = m_new_obj_with_finaliser(subitarray_obj_t);
     self->base.type = &subiterable_array_type;
-    self->len = mp_obj_get_int(args[0]);
-    uint16_t *arr = malloc(self->len * sizeof(uint16_t));
-    for(uint16_t i=0; i < self->len; i++) {
-        arr[i] = i*i;
+    self->elements = NULL;
+    self->len = 0;
+    self->closed = true;
+    self->owner = MP_OBJ_NULL;
+    self->map_len = 0;
+    self->dirty = NULL;
+
+    int fd = open(filename, flags);
+    if(fd < 0) {
+        mp_raise_OSError(errno);
+    }
+    struct stat st;
+    if(fstat(fd, &st) < 0) {
+        int err = errno;
+        close(fd);
+        mp_raise_OSError(err);
     }
-    self->elements = arr;
+    if(st.st_size < (off_t)sizeof(uint16_t)) {
+        close(fd);
+        mp_raise_ValueError("file is too short to be mapped");
+    }
+    size_t map_len = st.st_size;
+    void *map = mmap(NULL, map_len, prot, share, fd, 0);
+    int err = errno;
+    // the mapping holds its own reference to the file, the descriptor is no longer needed
+    close(fd);
+    if(map == MAP_FAILED) {
+        mp_raise_OSError(err);
+    }
+    self->elements = (uint16_t *)map;
+    // a trailing odd byte is not part of any element
+    self->len = map_len / sizeof(uint16_t);
+    self->map_len = map_len;
+    self->closed = false;
+    self->mode = mode;
     return MP_OBJ_FROM_PTR(self);
 }
 
+INSTRUMENT_WRAP_VAR(subscriptiterable_mmap)
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(subscriptiterable_mmap_obj, 1, 2, INSTRUMENT(subscriptiterable_mmap));
+#endif
+
+// Writes the modified pages of a write-through mapping back to the file
+STATIC mp_obj_t subitarray_flush(mp_obj_t self_in) {
+    subitarray_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    subitarray_check_open(self);
+#if SUBSCRIPTITERABLE_USE_MMAP
+    if((self->map_len != 0) && (self->mode == 'w')) {
+        if(msync(self->elements, self->map_len, MS_SYNC) < 0) {
+            mp_raise_OSError(errno);
+        }
+    }
+#endif
+    return mp_const_none;
+}
+
+INSTRUMENT_WRAP_1(subitarray_flush)
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(subitarray_flush_obj, INSTRUMENT(subitarray_flush));
+
+// Releases the elements; calling close on a closed array is a no-op
+STATIC mp_obj_t subitarray_close(mp_obj_t self_in) {
+    subitarray_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if(self->closed) {
+        return mp_const_none;
+    }
+    if(self->owner != MP_OBJ_NULL) {
+        // a view does not own its elements
+        self->owner = MP_OBJ_NULL;
+#if SUBSCRIPTITERABLE_USE_MMAP
+    } else if(self->map_len != 0) {
+        if(self->mode == 'w') {
+            msync(self->elements, self->map_len, MS_SYNC);
+        }
+        munmap(self->elements, self->map_len);
+        self->map_len = 0;
+#endif
+    } else {
+        free(self->elements);
+    }
+    subitarray_untrack(self);
+    self->elements = NULL;
+    self->len = 0;
+    self->closed = true;
+    return mp_const_none;
+}
+
+INSTRUMENT_WRAP_1(subitarray_close)
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(subitarray_close_obj, INSTRUMENT(subitarray_close));
+
 STATIC mp_obj_t subitarray_getiter(mp_obj_t o_in, mp_obj_iter_buf_t *iter_buf) {
+    subitarray_obj_t *self = MP_OBJ_TO_PTR(o_in);
+    subitarray_check_open(self);
+#if SUBSCRIPTITERABLE_USE_MMAP
+    if(self->map_len != 0) {
+        // let the kernel read ahead, and drop the pages behind us
+        madvise(self->elements, self->map_len, MADV_SEQUENTIAL);
+    }
+#endif
     return mp_obj_new_subitarray_iterator(o_in, 0, iter_buf);
 }
 
+STATIC mp_obj_t subitarray_unary_op(mp_unary_op_t op, mp_obj_t self_in) {
+    subitarray_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    switch (op) {
+        case MP_UNARY_OP_LEN: return mp_obj_new_int_from_uint(self->len);
+        default: return MP_OBJ_NULL; // operator not supported
+    }
+}
+
+#if MICROPY_PY_BUILTINS_SLICE
+// The value is another array, or an array of type 'H' of the same length as the slice;
+// the length of the array can't be changed
+STATIC void subitarray_assign_slice(subitarray_obj_t *self, size_t start, size_t step, size_t len, mp_obj_t value) {
+    subitarray_check_writable(self);
+    const uint16_t *src;
+    size_t src_len;
+    if(mp_obj_is_type(value, &subiterable_array_type)) {
+        subitarray_obj_t *other = MP_OBJ_TO_PTR(value);
+        subitarray_check_open(other);
+        src = other->elements;
+        src_len = other->len;
+    } else {
+        mp_buffer_info_t bufinfo;
+        mp_get_buffer_raise(value, &bufinfo, MP_BUFFER_READ);
+        if(bufinfo.typecode != 'H') {
+            mp_raise_TypeError("value must be an array of type 'H'");
+        }
+        src = bufinfo.buf;
+        src_len = bufinfo.len / sizeof(uint16_t);
+    }
+    if(src_len != len) {
+        mp_raise_ValueError("value must be as long as the slice");
+    }
+    if(len == 0) {
+        return;
+    }
+    uint16_t *dest = self->elements + start;
+    if(step == 1) {
+        // the source might be a view of the same memory
+        memmove(dest, src, len * sizeof(uint16_t));
+    } else {
+        uint16_t *scratch = NULL;
+        if((src < self->elements + self->len) && (self->elements < src + len)) {
+            scratch = uint16kernels_new_scratch(len);
+            memcpy(scratch, src, len * sizeof(uint16_t));
+            src = scratch;
+        }
+        for(size_t i=0; i < len; i++) {
+            dest[i*step] = src[i];
+        }
+        free(scratch);
+    }
+    subitarray_mark(self, start, start + (len - 1) * step + 1);
+}
+#endif
+
 STATIC mp_obj_t subitarray_subscr(mp_obj_t self_in, mp_obj_t index, mp_obj_t value) {
     subitarray_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    subitarray_check_open(self);
+#if MICROPY_PY_BUILTINS_SLICE
+    if (mp_obj_is_type(index, &mp_type_slice)) {
+        if (value == MP_OBJ_NULL) { // slices can't be deleted
+            return MP_OBJ_NULL;
+        }
+        // only the pages in the slice are touched, even if the array is memory-mapped
+        mp_bound_slice_t slice;
+        // the return value only tells, whether the step is 1; start, and stop are bound in either case
+        mp_seq_get_fast_slice_indexes(self->len, index, &slice);
+        if(slice.step <= 0) {
+            mp_raise_NotImplementedError("only slices with step > 0 are supported");
+        }
+        size_t len = slice.stop > slice.start ? (slice.stop - slice.start + slice.step - 1) / slice.step : 0;
+        if (value != MP_OBJ_SENTINEL) {
+            subitarray_assign_slice(self, slice.start, slice.step, len, value);
+            return mp_const_none;
+        }
+        subitarray_obj_t *res = create_new_subitarray(len);
+        for(size_t i=0; i < len; i++) {
+            res->elements[i] = self->elements[slice.start+i*slice.step];
+        }
+        return MP_OBJ_FROM_PTR(res);
+    }
+#endif
     size_t idx = mp_obj_get_int(index);
     if(self->len <= idx) {
         mp_raise_msg(&mp_type_IndexError, "index is out of range");
@@ -60,23 +542,268 @@ STATIC mp_obj_t subitarray_subscr(mp_obj_t self_in, mp_obj_t index, mp_obj_t val
     if (value == MP_OBJ_SENTINEL) { // simply return the value at index, no assignment
         return MP_OBJ_NEW_SMALL_INT(self->elements[idx]);
     } else { // value was passed, replace the element at index
+        subitarray_check_writable(self);
         self->elements[idx] = mp_obj_get_int(value);
+        subitarray_mark(self, idx, idx + 1);
+    }
+    return mp_const_none;
+}
+
+// Sorting and searching; the kernels in uint16kernels.h work on the raw elements, and allocate nothing but scratch memory
+
+STATIC mp_obj_t subitarray_sort(mp_obj_t self_in) {
+    subitarray_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    subitarray_check_writable(self);
+    if(self->len > 1) {
+        uint16kernels_sort(self->elements, self->len);
+        subitarray_mark(self, 0, self->len);
     }
     return mp_const_none;
 }
 
+INSTRUMENT_WRAP_1(subitarray_sort)
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(subitarray_sort_obj, INSTRUMENT(subitarray_sort));
+
+STATIC mp_obj_t subitarray_argsort(mp_obj_t self_in) {
+    subitarray_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    subitarray_check_open(self);
+    if(self->len > UINT16_MAX + 1) {
+        mp_raise_ValueError("array is too long for 16-bit indices");
+    }
+    subitarray_obj_t *res = create_new_subitarray(self->len);
+    uint16kernels_argsort(self->elements, res->elements, self->len);
+    return MP_OBJ_FROM_PTR(res);
+}
+
+INSTRUMENT_WRAP_1(subitarray_argsort)
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(subitarray_argsort_obj, INSTRUMENT(subitarray_argsort));
+
+STATIC mp_obj_t subitarray_searchsorted(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_value, MP_ARG_REQUIRED | MP_ARG_INT, {.u_int = 0} },
+        { MP_QSTR_right, MP_ARG_KW_ONLY | MP_ARG_BOOL, {.u_bool = false} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+    subitarray_obj_t *self = MP_OBJ_TO_PTR(pos_args[0]);
+    subitarray_check_open(self);
+    return mp_obj_new_int_from_uint(uint16kernels_bisect(self->elements, self->len, args[0].u_int, args[1].u_bool));
+}
+
+INSTRUMENT_WRAP_KW(subitarray_searchsorted)
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(subitarray_searchsorted_obj, 2, INSTRUMENT(subitarray_searchsorted));
+
+// Returns the distinct values in ascending order; the array itself is left untouched
+STATIC mp_obj_t subitarray_unique(mp_obj_t self_in) {
+    subitarray_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    subitarray_check_open(self);
+    const uint16_t *sorted;
+    void *work = uint16kernels_sorted(self->elements, self->len, &sorted);
+    subitarray_obj_t *res = create_new_subitarray(uint16kernels_unique(sorted, self->len, NULL));
+    uint16kernels_unique(sorted, self->len, res->elements);
+    free(work);
+    return MP_OBJ_FROM_PTR(res);
+}
+
+INSTRUMENT_WRAP_1(subitarray_unique)
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(subitarray_unique_obj, INSTRUMENT(subitarray_unique));
+
+// Binning; the counts go into a caller-supplied array of 32-bit integers ('I', or 'i'), to which they are
+// added, so that a histogram can be accumulated over several arrays. The counts have to be zeroed by the caller.
+
+// histogram(counts, start=0, width=1)
+STATIC mp_obj_t subitarray_histogram(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_counts, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_rom_obj = MP_ROM_NONE } },
+        { MP_QSTR_start, MP_ARG_INT, {.u_int = 0 } },
+        { MP_QSTR_width, MP_ARG_INT, {.u_int = 1 } },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+    subitarray_obj_t *self = MP_OBJ_TO_PTR(pos_args[0]);
+    subitarray_check_open(self);
+    if(args[2].u_int < 1) {
+        mp_raise_ValueError("width must be positive");
+    }
+    size_t nbins;
+    uint32_t *counts = uint16kernels_get_counts(args[0].u_obj, &nbins);
+    return mp_obj_new_int_from_uint(uint16kernels_histogram(self->elements, self->len, counts, nbins, args[1].u_int, args[2].u_int));
+}
+
+INSTRUMENT_WRAP_KW(subitarray_histogram)
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(subitarray_histogram_obj, 2, INSTRUMENT(subitarray_histogram));
+
+// bucketize(edges, counts)
+//
+// edges is an ascending array of the same type, or an array of type 'H', and counts must have
+// len(edges) + 1 elements. counts[i] is incremented for each value v with edges[i-1] <= v < edges[i];
+// the first and the last bucket are open towards 0, and 65535, respectively.
+STATIC mp_obj_t subitarray_bucketize(mp_obj_t self_in, mp_obj_t edges_in, mp_obj_t counts_in) {
+    subitarray_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    subitarray_check_open(self);
+    const uint16_t *edges;
+    size_t nedges;
+    if(mp_obj_is_type(edges_in, &subiterable_array_type)) {
+        subitarray_obj_t *other = MP_OBJ_TO_PTR(edges_in);
+        subitarray_check_open(other);
+        edges = other->elements;
+        nedges = other->len;
+    } else {
+        mp_buffer_info_t bufinfo;
+        mp_get_buffer_raise(edges_in, &bufinfo, MP_BUFFER_READ);
+        if(bufinfo.typecode != 'H') {
+            mp_raise_TypeError("edges must be an array of type 'H'");
+        }
+        edges = bufinfo.buf;
+        nedges = bufinfo.len / sizeof(uint16_t);
+    }
+    if(!uint16kernels_is_sorted(edges, nedges)) {
+        mp_raise_ValueError("edges must be in ascending order");
+    }
+    size_t nbins;
+    uint32_t *counts = uint16kernels_get_counts(counts_in, &nbins);
+    if(nbins != nedges + 1) {
+        mp_raise_ValueError("counts must be one longer than edges");
+    }
+    uint16kernels_bucketize(self->elements, self->len, edges, nedges, counts);
+    return counts_in;
+}
+
+INSTRUMENT_WRAP_3(subitarray_bucketize)
+STATIC MP_DEFINE_CONST_FUN_OBJ_3(subitarray_bucketize_obj, INSTRUMENT(subitarray_bucketize));
+
+// cumulative(counts)
+//
+// Replaces the counts by their running totals, in place; the totals saturate at 2^32-1
+STATIC mp_obj_t subscriptiterable_cumulative(mp_obj_t counts_in) {
+    size_t len;
+    uint32_t *counts = uint16kernels_get_counts(counts_in, &len);
+    uint16kernels_cumulative(counts, len);
+    return counts_in;
+}
+
+INSTRUMENT_WRAP_1(subscriptiterable_cumulative)
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(subscriptiterable_cumulative_obj, INSTRUMENT(subscriptiterable_cumulative));
+
+// Binary serialisation; the elements are written as 16-bit unsigned integers in the requested byte order
+
+STATIC mp_obj_t subitarray_pack_into(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_buffer, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_rom_obj = MP_ROM_NONE } },
+        { MP_QSTR_offset, MP_ARG_INT, {.u_int = 0 } },
+        { MP_QSTR_byteorder, MP_ARG_OBJ, {.u_rom_obj = MP_ROM_QSTR(MP_QSTR_little) } },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+    subitarray_obj_t *self = MP_OBJ_TO_PTR(pos_args[0]);
+    subitarray_check_open(self);
+    size_t nbytes = self->len * sizeof(uint16_t);
+    byte *dest = byteorder_buffer_at(args[0].u_obj, args[1].u_int, nbytes, MP_BUFFER_WRITE);
+    byteorder_store_uint16(dest, self->elements, self->len, byteorder_big_endian(args[2].u_obj));
+    return mp_obj_new_int_from_uint(args[1].u_int + nbytes);
+}
+
+INSTRUMENT_WRAP_KW(subitarray_pack_into)
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(subitarray_pack_into_obj, 2, INSTRUMENT(subitarray_pack_into));
+
+STATIC mp_obj_t subitarray_to_bytes(size_t n_args, const mp_obj_t *args) {
+    subitarray_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    subitarray_check_open(self);
+    bool big_endian = n_args > 1 ? byteorder_big_endian(args[1]) : false;
+    // the bytes object is created uninitialised, and filled in place
+    vstr_t vstr;
+    vstr_init_len(&vstr, self->len * sizeof(uint16_t));
+    byteorder_store_uint16((byte *)vstr.buf, self->elements, self->len, big_endian);
+    return mp_obj_new_str_from_vstr(&mp_type_bytes, &vstr);
+}
+
+INSTRUMENT_WRAP_VAR(subitarray_to_bytes)
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(subitarray_to_bytes_obj, 1, 2, INSTRUMENT(subitarray_to_bytes));
+
+// With view=True, the array is not copied: the elements are read from, and written to the buffer itself.
+// This is possible only, if the byte order is the native one, and the buffer is aligned. The view follows
+// its owner, if that is resized; a tracked view stops tracking, when the length changes.
+STATIC mp_obj_t subscriptiterable_from_bytes(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_buffer, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_rom_obj = MP_ROM_NONE } },
+        { MP_QSTR_byteorder, MP_ARG_OBJ, {.u_rom_obj = MP_ROM_QSTR(MP_QSTR_little) } },
+        { MP_QSTR_view, MP_ARG_KW_ONLY | MP_ARG_BOOL, {.u_bool = false } },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(args[0].u_obj, &bufinfo, MP_BUFFER_READ);
+    bool big_endian = byteorder_big_endian(args[1].u_obj);
+    size_t len = bufinfo.len / sizeof(uint16_t);
+    if(args[2].u_bool) {
+        if(big_endian != MP_ENDIANNESS_BIG) {
+            mp_raise_ValueError("a view must be in the native byte order");
+        }
+        if(((uintptr_t)bufinfo.buf & (sizeof(uint16_t) - 1)) != 0) {
+            mp_raise_ValueError("buffer is not aligned");
+        }
+        subitarray_obj_t *self = m_new_obj_with_finaliser(subitarray_obj_t);
+        self->base.type = &subiterable_array_type;
+        self->elements = (uint16_t *)bufinfo.buf;
+        self->len = len;
+        self->closed = false;
+        // the view can be written to only, if the buffer can
+        mp_buffer_info_t writeinfo;
+        self->mode = mp_get_buffer(args[0].u_obj, &writeinfo, MP_BUFFER_WRITE) ? 'w' : 'r';
+        self->owner = args[0].u_obj;
+#if SUBSCRIPTITERABLE_USE_MMAP
+        self->map_len = 0;
+#endif
+        self->dirty = NULL;
+        return MP_OBJ_FROM_PTR(self);
+    }
+    subitarray_obj_t *self = create_new_subitarray(len);
+    byteorder_load_uint16(self->elements, bufinfo.buf, len, big_endian);
+    return MP_OBJ_FROM_PTR(self);
+}
+
+INSTRUMENT_WRAP_KW(subscriptiterable_from_bytes)
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(subscriptiterable_from_bytes_obj, 1, INSTRUMENT(subscriptiterable_from_bytes));
+
+STATIC const mp_rom_map_elem_t subitarray_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_flush), MP_ROM_PTR(&subitarray_flush_obj) },
+    { MP_ROM_QSTR(MP_QSTR_close), MP_ROM_PTR(&subitarray_close_obj) },
+    { MP_ROM_QSTR(MP_QSTR___del__), MP_ROM_PTR(&subitarray_close_obj) },
+    { MP_ROM_QSTR(MP_QSTR_sort), MP_ROM_PTR(&subitarray_sort_obj) },
+    { MP_ROM_QSTR(MP_QSTR_argsort), MP_ROM_PTR(&subitarray_argsort_obj) },
+    { MP_ROM_QSTR(MP_QSTR_searchsorted), MP_ROM_PTR(&subitarray_searchsorted_obj) },
+    { MP_ROM_QSTR(MP_QSTR_unique), MP_ROM_PTR(&subitarray_unique_obj) },
+    { MP_ROM_QSTR(MP_QSTR_histogram), MP_ROM_PTR(&subitarray_histogram_obj) },
+    { MP_ROM_QSTR(MP_QSTR_bucketize), MP_ROM_PTR(&subitarray_bucketize_obj) },
+    { MP_ROM_QSTR(MP_QSTR_to_bytes), MP_ROM_PTR(&subitarray_to_bytes_obj) },
+    { MP_ROM_QSTR(MP_QSTR_pack_into), MP_ROM_PTR(&subitarray_pack_into_obj) },
+    { MP_ROM_QSTR(MP_QSTR_track), MP_ROM_PTR(&subitarray_track_obj) },
+    { MP_ROM_QSTR(MP_QSTR_changes), MP_ROM_PTR(&subitarray_changes_obj) },
+};
+
+STATIC MP_DEFINE_CONST_DICT(subitarray_locals_dict, subitarray_locals_dict_table);
+
+INSTRUMENT_WRAP_3(subitarray_subscr)
+
 const mp_obj_type_t subiterable_array_type = {
     { &mp_type_type },
     .name = MP_QSTR_subitarray,
     .print = subitarray_print,
     .make_new = subitarray_make_new,
+    .unary_op = subitarray_unary_op,
     .getiter = subitarray_getiter,
-    .subscr = subitarray_subscr,
+    .subscr = INSTRUMENT(subitarray_subscr),
+    .locals_dict = (mp_obj_dict_t*)&subitarray_locals_dict,
 };
 
 STATIC const mp_rom_map_elem_t subscriptiterable_module_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_subscriptiterable) },
     { MP_OBJ_NEW_QSTR(MP_QSTR_square), (mp_obj_t)&subiterable_array_type },
+    { MP_ROM_QSTR(MP_QSTR_from_bytes), MP_ROM_PTR(&subscriptiterable_from_bytes_obj) },
+    { MP_ROM_QSTR(MP_QSTR_cumulative), MP_ROM_PTR(&subscriptiterable_cumulative_obj) },
+#if SUBSCRIPTITERABLE_USE_MMAP
+    { MP_ROM_QSTR(MP_QSTR_mmap), MP_ROM_PTR(&subscriptiterable_mmap_obj) },
+#endif
 };
 STATIC MP_DEFINE_CONST_DICT(subscriptiterable_module_globals, subscriptiterable_module_globals_table);
 
@@ -98,6 +825,8 @@ typedef struct _mp_obj_subitarray_it_t {
 mp_obj_t subitarray_iternext(mp_obj_t self_in) {
     mp_obj_subitarray_it_t *self = MP_OBJ_TO_PTR(self_in);
     subitarray_obj_t *subitarray = MP_OBJ_TO_PTR(self->subitarray);
+    // the length is re-read in each step, because the array might have been closed, or its owner resized in the meantime
+    subitarray_refresh(subitarray);
     if (self->cur < subitarray->len) {
         // read the current value
         uint16_t *arr = subitarray->elements;
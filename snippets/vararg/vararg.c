@@ -10,6 +10,7 @@
     
 #include "py/obj.h"
 #include "py/runtime.h"
+#include "instrument.h"
 
 STATIC mp_obj_t vararg_function(size_t n_args, const mp_obj_t *args) {
     if(n_args == 0) {
@@ -24,7 +25,8 @@ STATIC mp_obj_t vararg_function(size_t n_args, const mp_obj_t *args) {
     return mp_const_none;
 } 
 
-STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(vararg_function_obj, 0, 3, vararg_function);
+INSTRUMENT_WRAP_VAR(vararg_function)
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(vararg_function_obj, 0, 3, INSTRUMENT(vararg_function));
 
 STATIC const mp_rom_map_elem_t vararg_module_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_vararg) },
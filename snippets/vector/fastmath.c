@@ -0,0 +1,219 @@
+/*
+ * This file is part of the micropython-usermod project, 
+ *
+ * https://github.com/v923z/micropython-usermod
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020 Zoltán Vörös
+*/
+    
+#include <math.h>
+#include <stdint.h>
+#include "py/obj.h"
+#include "py/runtime.h"
+#include "vector.h"
+
+// Approximate square roots, and table-driven trigonometric functions for the vector kernels.
+// The error bounds below were measured with gcc on x86-64, against double-precision results.
+//
+//  Newton steps   max. relative error of vector_fast_rsqrt
+//  0              3.5e-2
+//  1              1.8e-3
+//  2              4.8e-6
+//  3              1.5e-7 (the rounding error of float itself)
+//
+//  fast_sin, fast_cos   max. absolute error 4.8e-6 for |x| < 4, and 1.4e-5 for |x| < 100,
+//                       where the reduction of the argument in float dominates
+//  fast_atan2           max. absolute error 1.6e-6 rad
+
+#define VECTOR_PI (3.14159265358979323846)
+
+// The number of intervals in the tables; the tables below have to be regenerated, if this is changed
+#define VECTOR_LUT_SIZE (256)
+
+// The default of the fast keyword argument; VECTOR_FASTMATH_EXACT means sqrtf
+int8_t vector_fastmath = VECTOR_FASTMATH_EXACT;
+
+// The reciprocal square root from the bit pattern of the float, followed by the given number
+// of Newton-Raphson steps, each of which roughly doubles the number of correct digits
+float vector_fast_rsqrt(float x, uint8_t steps) {
+    union { float f; uint32_t i; } u = { .f = x };
+    u.i = 0x5f375a86 - (u.i >> 1);
+    float y = u.f, half = 0.5f * x;
+    for(uint8_t i=0; i < steps; i++) {
+        y = y * (1.5f - half * y * y);
+    }
+    return y;
+}
+
+float vector_sqrt(float x, int8_t steps) {
+    if(steps < 0) {
+        return sqrtf(x);
+    }
+    // the approximation is not defined at 0, and the infinities
+    if(!(x > 0.0f) || isinf(x)) {
+        return sqrtf(x);
+    }
+    return x * vector_fast_rsqrt(x, steps);
+}
+
+// sin(x) for x = i * pi / (2 * VECTOR_LUT_SIZE)
+STATIC const float vector_sin_table[VECTOR_LUT_SIZE + 1] = {
+    0.000000000e+00f, 6.135884649e-03f, 1.227153829e-02f, 1.840672991e-02f, 2.454122852e-02f, 3.067480318e-02f,
+    3.680722294e-02f, 4.293825693e-02f, 4.906767433e-02f, 5.519524435e-02f, 6.132073630e-02f, 6.744391956e-02f,
+    7.356456360e-02f, 7.968243797e-02f, 8.579731234e-02f, 9.190895650e-02f, 9.801714033e-02f, 1.041216339e-01f,
+    1.102222073e-01f, 1.163186309e-01f, 1.224106752e-01f, 1.284981108e-01f, 1.345807085e-01f, 1.406582393e-01f,
+    1.467304745e-01f, 1.527971853e-01f, 1.588581433e-01f, 1.649131205e-01f, 1.709618888e-01f, 1.770042204e-01f,
+    1.830398880e-01f, 1.890686641e-01f, 1.950903220e-01f, 2.011046348e-01f, 2.071113762e-01f, 2.131103199e-01f,
+    2.191012402e-01f, 2.250839114e-01f, 2.310581083e-01f, 2.370236060e-01f, 2.429801799e-01f, 2.489276057e-01f,
+    2.548656596e-01f, 2.607941179e-01f, 2.667127575e-01f, 2.726213554e-01f, 2.785196894e-01f, 2.844075372e-01f,
+    2.902846773e-01f, 2.961508882e-01f, 3.020059493e-01f, 3.078496400e-01f, 3.136817404e-01f, 3.195020308e-01f,
+    3.253102922e-01f, 3.311063058e-01f, 3.368898534e-01f, 3.426607173e-01f, 3.484186802e-01f, 3.541635254e-01f,
+    3.598950365e-01f, 3.656129978e-01f, 3.713171940e-01f, 3.770074102e-01f, 3.826834324e-01f, 3.883450467e-01f,
+    3.939920401e-01f, 3.996241998e-01f, 4.052413140e-01f, 4.108431711e-01f, 4.164295601e-01f, 4.220002708e-01f,
+    4.275550934e-01f, 4.330938189e-01f, 4.386162385e-01f, 4.441221446e-01f, 4.496113297e-01f, 4.550835871e-01f,
+    4.605387110e-01f, 4.659764958e-01f, 4.713967368e-01f, 4.767992301e-01f, 4.821837721e-01f, 4.875501601e-01f,
+    4.928981922e-01f, 4.982276670e-01f, 5.035383837e-01f, 5.088301425e-01f, 5.141027442e-01f, 5.193559902e-01f,
+    5.245896827e-01f, 5.298036247e-01f, 5.349976199e-01f, 5.401714727e-01f, 5.453249884e-01f, 5.504579729e-01f,
+    5.555702330e-01f, 5.606615762e-01f, 5.657318108e-01f, 5.707807459e-01f, 5.758081914e-01f, 5.808139581e-01f,
+    5.857978575e-01f, 5.907597019e-01f, 5.956993045e-01f, 6.006164794e-01f, 6.055110414e-01f, 6.103828063e-01f,
+    6.152315906e-01f, 6.200572118e-01f, 6.248594881e-01f, 6.296382389e-01f, 6.343932842e-01f, 6.391244449e-01f,
+    6.438315429e-01f, 6.485144010e-01f, 6.531728430e-01f, 6.578066933e-01f, 6.624157776e-01f, 6.669999223e-01f,
+    6.715589548e-01f, 6.760927036e-01f, 6.806009978e-01f, 6.850836678e-01f, 6.895405447e-01f, 6.939714609e-01f,
+    6.983762494e-01f, 7.027547445e-01f, 7.071067812e-01f, 7.114321957e-01f, 7.157308253e-01f, 7.200025080e-01f,
+    7.242470830e-01f, 7.284643904e-01f, 7.326542717e-01f, 7.368165689e-01f, 7.409511254e-01f, 7.450577854e-01f,
+    7.491363945e-01f, 7.531867990e-01f, 7.572088465e-01f, 7.612023855e-01f, 7.651672656e-01f, 7.691033376e-01f,
+    7.730104534e-01f, 7.768884657e-01f, 7.807372286e-01f, 7.845565972e-01f, 7.883464276e-01f, 7.921065773e-01f,
+    7.958369046e-01f, 7.995372691e-01f, 8.032075315e-01f, 8.068475535e-01f, 8.104571983e-01f, 8.140363297e-01f,
+    8.175848132e-01f, 8.211025150e-01f, 8.245893028e-01f, 8.280450453e-01f, 8.314696123e-01f, 8.348628750e-01f,
+    8.382247056e-01f, 8.415549774e-01f, 8.448535652e-01f, 8.481203448e-01f, 8.513551931e-01f, 8.545579884e-01f,
+    8.577286100e-01f, 8.608669386e-01f, 8.639728561e-01f, 8.670462455e-01f, 8.700869911e-01f, 8.730949784e-01f,
+    8.760700942e-01f, 8.790122264e-01f, 8.819212643e-01f, 8.847970984e-01f, 8.876396204e-01f, 8.904487232e-01f,
+    8.932243012e-01f, 8.959662498e-01f, 8.986744657e-01f, 9.013488470e-01f, 9.039892931e-01f, 9.065957045e-01f,
+    9.091679831e-01f, 9.117060320e-01f, 9.142097557e-01f, 9.166790599e-01f, 9.191138517e-01f, 9.215140393e-01f,
+    9.238795325e-01f, 9.262102421e-01f, 9.285060805e-01f, 9.307669611e-01f, 9.329927988e-01f, 9.351835099e-01f,
+    9.373390119e-01f, 9.394592236e-01f, 9.415440652e-01f, 9.435934582e-01f, 9.456073254e-01f, 9.475855910e-01f,
+    9.495281806e-01f, 9.514350210e-01f, 9.533060404e-01f, 9.551411683e-01f, 9.569403357e-01f, 9.587034749e-01f,
+    9.604305194e-01f, 9.621214043e-01f, 9.637760658e-01f, 9.653944417e-01f, 9.669764710e-01f, 9.685220943e-01f,
+    9.700312532e-01f, 9.715038910e-01f, 9.729399522e-01f, 9.743393828e-01f, 9.757021300e-01f, 9.770281427e-01f,
+    9.783173707e-01f, 9.795697657e-01f, 9.807852804e-01f, 9.819638691e-01f, 9.831054874e-01f, 9.842100924e-01f,
+    9.852776424e-01f, 9.863080972e-01f, 9.873014182e-01f, 9.882575677e-01f, 9.891765100e-01f, 9.900582103e-01f,
+    9.909026354e-01f, 9.917097537e-01f, 9.924795346e-01f, 9.932119492e-01f, 9.939069700e-01f, 9.945645707e-01f,
+    9.951847267e-01f, 9.957674145e-01f, 9.963126122e-01f, 9.968202993e-01f, 9.972904567e-01f, 9.977230666e-01f,
+    9.981181129e-01f, 9.984755806e-01f, 9.987954562e-01f, 9.990777278e-01f, 9.993223846e-01f, 9.995294175e-01f,
+    9.996988187e-01f, 9.998305818e-01f, 9.999247018e-01f, 9.999811753e-01f, 1.000000000e+00f,
+};
+
+// atan(x) for x = i / VECTOR_LUT_SIZE
+STATIC const float vector_atan_table[VECTOR_LUT_SIZE + 1] = {
+    0.000000000e+00f, 3.906230132e-03f, 7.812341060e-03f, 1.171821360e-02f, 1.562372862e-02f, 1.952876704e-02f,
+    2.343320988e-02f, 2.733693826e-02f, 3.123983343e-02f, 3.514177680e-02f, 3.904264996e-02f, 4.294233466e-02f,
+    4.684071292e-02f, 5.073766695e-02f, 5.463307924e-02f, 5.852683257e-02f, 6.241881000e-02f, 6.630889492e-02f,
+    7.019697107e-02f, 7.408292255e-02f, 7.796663383e-02f, 8.184798980e-02f, 8.572687577e-02f, 8.960317748e-02f,
+    9.347678116e-02f, 9.734757349e-02f, 1.012154417e-01f, 1.050802734e-01f, 1.089419570e-01f, 1.128003812e-01f,
+    1.166554354e-01f, 1.205070097e-01f, 1.243549945e-01f, 1.281992812e-01f, 1.320397616e-01f, 1.358763282e-01f,
+    1.397088743e-01f, 1.435372937e-01f, 1.473614811e-01f, 1.511813318e-01f, 1.549967419e-01f, 1.588076083e-01f,
+    1.626138286e-01f, 1.664153012e-01f, 1.702119253e-01f, 1.740036009e-01f, 1.777902290e-01f, 1.815717112e-01f,
+    1.853479500e-01f, 1.891188489e-01f, 1.928843123e-01f, 1.966442452e-01f, 2.003985538e-01f, 2.041471452e-01f,
+    2.078899272e-01f, 2.116268088e-01f, 2.153576997e-01f, 2.190825108e-01f, 2.228011538e-01f, 2.265135414e-01f,
+    2.302195873e-01f, 2.339192062e-01f, 2.376123139e-01f, 2.412988269e-01f, 2.449786631e-01f, 2.486517412e-01f,
+    2.523179809e-01f, 2.559773030e-01f, 2.596296294e-01f, 2.632748830e-01f, 2.669129876e-01f, 2.705438683e-01f,
+    2.741674511e-01f, 2.777836632e-01f, 2.813924326e-01f, 2.849936888e-01f, 2.885873619e-01f, 2.921733834e-01f,
+    2.957516858e-01f, 2.993222025e-01f, 3.028848684e-01f, 3.064396190e-01f, 3.099863912e-01f, 3.135251230e-01f,
+    3.170557532e-01f, 3.205782220e-01f, 3.240924705e-01f, 3.275984410e-01f, 3.310960767e-01f, 3.345853222e-01f,
+    3.380661228e-01f, 3.415384253e-01f, 3.450021772e-01f, 3.484573273e-01f, 3.519038254e-01f, 3.553416224e-01f,
+    3.587706703e-01f, 3.621909220e-01f, 3.656023317e-01f, 3.690048545e-01f, 3.723984467e-01f, 3.757830654e-01f,
+    3.791586690e-01f, 3.825252169e-01f, 3.858826694e-01f, 3.892309880e-01f, 3.925701350e-01f, 3.959000741e-01f,
+    3.992207696e-01f, 4.025321871e-01f, 4.058342931e-01f, 4.091270551e-01f, 4.124104416e-01f, 4.156844221e-01f,
+    4.189489671e-01f, 4.222040481e-01f, 4.254496374e-01f, 4.286857084e-01f, 4.319122355e-01f, 4.351291939e-01f,
+    4.383365599e-01f, 4.415343105e-01f, 4.447224240e-01f, 4.479008792e-01f, 4.510696560e-01f, 4.542287353e-01f,
+    4.573780987e-01f, 4.605177288e-01f, 4.636476090e-01f, 4.667677237e-01f, 4.698780580e-01f, 4.729785979e-01f,
+    4.760693303e-01f, 4.791502429e-01f, 4.822213242e-01f, 4.852825636e-01f, 4.883339511e-01f, 4.913754777e-01f,
+    4.944071351e-01f, 4.974289158e-01f, 5.004408131e-01f, 5.034428211e-01f, 5.064349345e-01f, 5.094171488e-01f,
+    5.123894603e-01f, 5.153518660e-01f, 5.183043636e-01f, 5.212469515e-01f, 5.241796288e-01f, 5.271023953e-01f,
+    5.300152514e-01f, 5.329181984e-01f, 5.358112380e-01f, 5.386943726e-01f, 5.415676054e-01f, 5.444309401e-01f,
+    5.472843810e-01f, 5.501279331e-01f, 5.529616020e-01f, 5.557853938e-01f, 5.585993153e-01f, 5.614033739e-01f,
+    5.641975774e-01f, 5.669819342e-01f, 5.697564535e-01f, 5.725211447e-01f, 5.752760180e-01f, 5.780210839e-01f,
+    5.807563536e-01f, 5.834818387e-01f, 5.861975514e-01f, 5.889035042e-01f, 5.915997103e-01f, 5.942861833e-01f,
+    5.969629372e-01f, 5.996299865e-01f, 6.022873461e-01f, 6.049350315e-01f, 6.075730584e-01f, 6.102014431e-01f,
+    6.128202022e-01f, 6.154293528e-01f, 6.180289123e-01f, 6.206188986e-01f, 6.231993299e-01f, 6.257702249e-01f,
+    6.283316024e-01f, 6.308834819e-01f, 6.334258830e-01f, 6.359588257e-01f, 6.384823304e-01f, 6.409964177e-01f,
+    6.435011088e-01f, 6.459964249e-01f, 6.484823876e-01f, 6.509590190e-01f, 6.534263412e-01f, 6.558843767e-01f,
+    6.583331484e-01f, 6.607726793e-01f, 6.632029927e-01f, 6.656241123e-01f, 6.680360619e-01f, 6.704388655e-01f,
+    6.728325476e-01f, 6.752171327e-01f, 6.775926455e-01f, 6.799591112e-01f, 6.823165549e-01f, 6.846650020e-01f,
+    6.870044783e-01f, 6.893350096e-01f, 6.916566219e-01f, 6.939693413e-01f, 6.962731944e-01f, 6.985682077e-01f,
+    7.008544079e-01f, 7.031318219e-01f, 7.054004769e-01f, 7.076603999e-01f, 7.099116185e-01f, 7.121541600e-01f,
+    7.143880522e-01f, 7.166133227e-01f, 7.188299996e-01f, 7.210381109e-01f, 7.232376846e-01f, 7.254287490e-01f,
+    7.276113326e-01f, 7.297854638e-01f, 7.319511711e-01f, 7.341084833e-01f, 7.362574290e-01f, 7.383980371e-01f,
+    7.405303366e-01f, 7.426543565e-01f, 7.447701257e-01f, 7.468776736e-01f, 7.489770292e-01f, 7.510682219e-01f,
+    7.531512810e-01f, 7.552262358e-01f, 7.572931159e-01f, 7.593519507e-01f, 7.614027698e-01f, 7.634456027e-01f,
+    7.654804790e-01f, 7.675074283e-01f, 7.695264804e-01f, 7.715376649e-01f, 7.735410116e-01f, 7.755365502e-01f,
+    7.775243104e-01f, 7.795043220e-01f, 7.814766149e-01f, 7.834412187e-01f, 7.853981634e-01f,
+};
+
+// Linear interpolation in the table at position p, with 0 <= p <= VECTOR_LUT_SIZE
+static inline float vector_lut(const float *table, float p) {
+    int32_t i = (int32_t)p;
+    if(i >= VECTOR_LUT_SIZE) {
+        i = VECTOR_LUT_SIZE - 1;
+    }
+    return table[i] + (p - i) * (table[i+1] - table[i]);
+}
+
+// x is given in turns, i.e., a full circle is 1
+STATIC float vector_lut_sin_turns(float turns) {
+    turns -= floorf(turns);
+    // for tiny negative turns, the difference rounds up to 1, which is the same angle as 0
+    if(turns >= 1.0f) {
+        turns -= 1.0f;
+    }
+    float p = turns * (4 * VECTOR_LUT_SIZE);
+    if(p >= 4 * VECTOR_LUT_SIZE) {
+        p = 0.0f;
+    }
+    uint8_t quadrant = (uint8_t)((int32_t)p / VECTOR_LUT_SIZE) & 3;
+    p -= quadrant * VECTOR_LUT_SIZE;
+    switch(quadrant) {
+        case 0: return vector_lut(vector_sin_table, p);
+        case 1: return vector_lut(vector_sin_table, VECTOR_LUT_SIZE - p);
+        case 2: return -vector_lut(vector_sin_table, p);
+        default: return -vector_lut(vector_sin_table, VECTOR_LUT_SIZE - p);
+    }
+}
+
+float vector_fast_sin(float x) {
+    if(!isfinite(x)) {
+        return NAN;
+    }
+    return vector_lut_sin_turns(x * (float)(0.5 / VECTOR_PI));
+}
+
+float vector_fast_cos(float x) {
+    if(!isfinite(x)) {
+        return NAN;
+    }
+    return vector_lut_sin_turns(x * (float)(0.5 / VECTOR_PI) + 0.25f);
+}
+
+float vector_fast_atan2(float y, float x) {
+    if(isnan(x) || isnan(y)) {
+        return NAN;
+    }
+    float ax = fabsf(x), ay = fabsf(y), a;
+    if((ax == 0.0f) && (ay == 0.0f)) {
+        a = 0.0f;
+    } else if(isinf(ax) && isinf(ay)) {
+        // the ratio would be NaN, but the direction is the diagonal
+        a = (float)(VECTOR_PI / 4);
+    } else if(ay <= ax) {
+        // the octant below the diagonal, where atan is tabulated
+        a = vector_lut(vector_atan_table, (ay / ax) * VECTOR_LUT_SIZE);
+    } else {
+        a = (float)(VECTOR_PI / 2) - vector_lut(vector_atan_table, (ax / ay) * VECTOR_LUT_SIZE);
+    }
+    if(signbit(x)) {
+        a = (float)VECTOR_PI - a;
+    }
+    return signbit(y) ? -a : a;
+}
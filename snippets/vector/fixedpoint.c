@@ -0,0 +1,325 @@
+/*
+ * This file is part of the micropython-usermod project, 
+ *
+ * https://github.com/v923z/micropython-usermod
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020 Zoltán Vörös
+*/
+    
+#include <math.h>
+#include <stdint.h>
+#include "py/obj.h"
+#include "py/runtime.h"
+#include "vector.h"
+#include "instrument.h"
+
+// Fixed-point vectors hold their components as signed integers with q fractional bits, in
+// the Q15, or the Q31 format. All arithmetic saturates at the limits of the format, and
+// no floating point operation is involved, except for the conversion to, and from vector.
+
+#define QVECTOR_MAX(q) ((q) == 15 ? (int64_t)INT16_MAX : (int64_t)INT32_MAX)
+#define QVECTOR_MIN(q) ((q) == 15 ? (int64_t)INT16_MIN : (int64_t)INT32_MIN)
+
+static inline int32_t qvector_saturate(int64_t value, uint8_t q) {
+    if(value > QVECTOR_MAX(q)) {
+        return (int32_t)QVECTOR_MAX(q);
+    }
+    if(value < QVECTOR_MIN(q)) {
+        return (int32_t)QVECTOR_MIN(q);
+    }
+    return (int32_t)value;
+}
+
+// The product of two fixed-point numbers, rounded to nearest
+static inline int32_t qvector_multiply(int32_t a, int32_t b, uint8_t q) {
+    int64_t product = (int64_t)a * b + ((int64_t)1 << (q - 1));
+    return qvector_saturate(product >> q, q);
+}
+
+// The rounded square root of a 32-bit number, computed bit by bit
+STATIC uint32_t qvector_isqrt32(uint32_t n) {
+    uint32_t root = 0, bit = (uint32_t)1 << 30;
+    while(bit > n) {
+        bit >>= 2;
+    }
+    while(bit != 0) {
+        if(n >= root + bit) {
+            n -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    // n now holds the remainder, and the root is rounded up, if the remainder is larger than the root
+    return n > root ? root + 1 : root;
+}
+
+STATIC uint64_t qvector_isqrt64(uint64_t n) {
+    uint64_t root = 0, bit = (uint64_t)1 << 62;
+    while(bit > n) {
+        bit >>= 2;
+    }
+    while(bit != 0) {
+        if(n >= root + bit) {
+            n -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return n > root ? root + 1 : root;
+}
+
+// The length of a fixed-point vector in the same format. The sum of the squares fits into
+// 32 bits for Q15, and into 64 bits for Q31, because each square is at most 2^(2q).
+static inline int32_t qvector_length_raw(int32_t x, int32_t y, int32_t z, uint8_t q) {
+    if(q == 15) {
+        uint32_t sum = (uint32_t)(x*x) + (uint32_t)(y*y) + (uint32_t)(z*z);
+        return qvector_saturate(qvector_isqrt32(sum), q);
+    }
+    uint64_t sum = (uint64_t)((int64_t)x*x) + (uint64_t)((int64_t)y*y) + (uint64_t)((int64_t)z*z);
+    return qvector_saturate((int64_t)qvector_isqrt64(sum), q);
+}
+
+STATIC uint8_t qvector_get_format(mp_int_t q) {
+    if((q != 15) && (q != 31)) {
+        mp_raise_ValueError("q must be 15, or 31");
+    }
+    return (uint8_t)q;
+}
+
+mp_obj_t create_new_qvector(int32_t x, int32_t y, int32_t z, uint8_t q) {
+    qvector_obj_t *vector = m_new_obj(qvector_obj_t);
+    vector->base.type = &qvector_type;
+    vector->q = q;
+    vector->x = x;
+    vector->y = y;
+    vector->z = z;
+    return MP_OBJ_FROM_PTR(vector);
+}
+
+STATIC int32_t qvector_from_float(float value, uint8_t q) {
+    // NaN fails both comparisons below, and its conversion is undefined
+    if(isnan(value)) {
+        mp_raise_ValueError("cannot convert NaN to fixed point");
+    }
+    float scaled = value * (float)((int64_t)1 << q);
+    // the comparison has to come before the conversion, which is undefined out of range
+    if(scaled >= (float)QVECTOR_MAX(q)) {
+        return (int32_t)QVECTOR_MAX(q);
+    }
+    if(scaled <= (float)QVECTOR_MIN(q)) {
+        return (int32_t)QVECTOR_MIN(q);
+    }
+    return (int32_t)(scaled < 0.0f ? scaled - 0.5f : scaled + 0.5f);
+}
+
+STATIC float qvector_to_float(int32_t value, uint8_t q) {
+    return (float)value / (float)((int64_t)1 << q);
+}
+
+STATIC void qvector_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t kind) {
+    (void)kind;
+    qvector_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    mp_printf(print, "qvector(%d, %d, %d, q=%u)", (int)self->x, (int)self->y, (int)self->z, self->q);
+}
+
+// qvector(x, y, z, *, q=15)
+//
+// The components are the raw integers, e.g., qvector(16384, 0, 0) is (0.5, 0, 0) in Q15.
+STATIC mp_obj_t qvector_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_x, MP_ARG_REQUIRED | MP_ARG_INT, {.u_int = 0 } },
+        { MP_QSTR_y, MP_ARG_REQUIRED | MP_ARG_INT, {.u_int = 0 } },
+        { MP_QSTR_z, MP_ARG_REQUIRED | MP_ARG_INT, {.u_int = 0 } },
+        { MP_QSTR_q, MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = 15 } },
+    };
+    mp_arg_val_t _args[MP_ARRAY_SIZE(allowed_args)];
+    mp_map_t kw_args;
+    mp_map_init_fixed_table(&kw_args, n_kw, args + n_args);
+    mp_arg_parse_all(n_args, args, &kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, _args);
+
+    uint8_t q = qvector_get_format(_args[3].u_int);
+    return create_new_qvector(qvector_saturate(_args[0].u_int, q), qvector_saturate(_args[1].u_int, q),
+                                qvector_saturate(_args[2].u_int, q), q);
+}
+
+STATIC mp_obj_t qvector_subscr(mp_obj_t self_in, mp_obj_t index, mp_obj_t value) {
+    if(value != MP_OBJ_SENTINEL) {
+        return MP_OBJ_NULL; // op not supported
+    }
+    qvector_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    mp_int_t idx = mp_obj_get_int(index);
+    if(idx < 0) {
+        idx += 3;
+    }
+    switch(idx) {
+        case 0: return mp_obj_new_int(self->x);
+        case 1: return mp_obj_new_int(self->y);
+        case 2: return mp_obj_new_int(self->z);
+    }
+    mp_raise_msg(&mp_type_IndexError, "index out of range");
+}
+
+STATIC mp_obj_t qvector_binary_op(mp_binary_op_t op, mp_obj_t lhs, mp_obj_t rhs) {
+    qvector_obj_t *self = MP_OBJ_TO_PTR(lhs);
+    uint8_t q = self->q;
+    if(op == MP_BINARY_OP_MULTIPLY && mp_obj_is_int(rhs)) {
+        // scaling by an integer; the factor is clamped, so that the product fits into 64 bits
+        int64_t n = qvector_saturate(mp_obj_get_int(rhs), 31);
+        return create_new_qvector(qvector_saturate(self->x * n, q), qvector_saturate(self->y * n, q),
+                                    qvector_saturate(self->z * n, q), q);
+    }
+    if(!mp_obj_is_type(rhs, &qvector_type)) {
+        return MP_OBJ_NULL; // operator not supported
+    }
+    qvector_obj_t *other = MP_OBJ_TO_PTR(rhs);
+    if(op == MP_BINARY_OP_EQUAL) {
+        return mp_obj_new_bool((other->q == q) && (self->x == other->x) && (self->y == other->y) && (self->z == other->z));
+    }
+    if(other->q != q) {
+        mp_raise_TypeError("the fixed-point formats differ");
+    }
+    switch (op) {
+        case MP_BINARY_OP_ADD:
+            return create_new_qvector(qvector_saturate((int64_t)self->x + other->x, q),
+                                        qvector_saturate((int64_t)self->y + other->y, q),
+                                        qvector_saturate((int64_t)self->z + other->z, q), q);
+        case MP_BINARY_OP_SUBTRACT:
+            return create_new_qvector(qvector_saturate((int64_t)self->x - other->x, q),
+                                        qvector_saturate((int64_t)self->y - other->y, q),
+                                        qvector_saturate((int64_t)self->z - other->z, q), q);
+        case MP_BINARY_OP_MULTIPLY:
+            return create_new_qvector(qvector_multiply(self->x, other->x, q),
+                                        qvector_multiply(self->y, other->y, q),
+                                        qvector_multiply(self->z, other->z, q), q);
+        default:
+            return MP_OBJ_NULL; // operator not supported
+    }
+}
+
+// Returns the length as a raw integer in the format of the vector
+STATIC mp_obj_t qvector_length(mp_obj_t self_in) {
+    qvector_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    return mp_obj_new_int(qvector_length_raw(self->x, self->y, self->z, self->q));
+}
+
+INSTRUMENT_WRAP_1(qvector_length)
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(qvector_length_obj, INSTRUMENT(qvector_length));
+
+STATIC mp_obj_t qvector_to_vector(mp_obj_t self_in) {
+    qvector_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    return create_new_vector(qvector_to_float(self->x, self->q), qvector_to_float(self->y, self->q),
+                                qvector_to_float(self->z, self->q));
+}
+
+INSTRUMENT_WRAP_1(qvector_to_vector)
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(qvector_to_vector_obj, INSTRUMENT(qvector_to_vector));
+
+STATIC const mp_rom_map_elem_t qvector_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_length), MP_ROM_PTR(&qvector_length_obj) },
+    { MP_ROM_QSTR(MP_QSTR_to_vector), MP_ROM_PTR(&qvector_to_vector_obj) },
+};
+
+STATIC MP_DEFINE_CONST_DICT(qvector_locals_dict, qvector_locals_dict_table);
+
+INSTRUMENT_WRAP_3(qvector_subscr)
+INSTRUMENT_WRAP_BINARY_OP(qvector_binary_op)
+
+const mp_obj_type_t qvector_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_qvector,
+    .print = qvector_print,
+    .make_new = qvector_make_new,
+    .subscr = INSTRUMENT(qvector_subscr),
+    .binary_op = INSTRUMENT(qvector_binary_op),
+    .locals_dict = (mp_obj_dict_t*)&qvector_locals_dict,
+};
+
+// fixed(v, q=15)
+//
+// Converts a vector to a qvector; components outside of [-1, 1) saturate, and NaN raises ValueError
+mp_obj_t vector_fixed(size_t n_args, const mp_obj_t *args) {
+    vector_obj_t *vector = vector_get(args[0]);
+    uint8_t q = qvector_get_format(n_args > 1 ? mp_obj_get_int(args[1]) : 15);
+    return create_new_qvector(qvector_from_float(vector->x, q), qvector_from_float(vector->y, q),
+                                qvector_from_float(vector->z, q), q);
+}
+
+// Returns the format of an array of x, y, z triplets: 'h' holds Q15, and 'i' holds Q31 numbers
+STATIC uint8_t qvector_buffer_format(mp_buffer_info_t *bufinfo) {
+    if(bufinfo->typecode == 'h') {
+        return 15;
+    }
+    if((bufinfo->typecode == 'i') && (sizeof(int) == 4)) {
+        return 31;
+    }
+    mp_raise_TypeError("array must be of type 'h', or 'i'");
+}
+
+// qlengths(vectors, out)
+//
+// Writes the lengths of the x, y, z triplets of vectors into out, which must be an array of the same type
+mp_obj_t vector_qlengths(mp_obj_t vectors, mp_obj_t out) {
+    mp_buffer_info_t src, dst;
+    mp_get_buffer_raise(vectors, &src, MP_BUFFER_READ);
+    mp_get_buffer_raise(out, &dst, MP_BUFFER_WRITE);
+    uint8_t q = qvector_buffer_format(&src);
+    if(dst.typecode != src.typecode) {
+        mp_raise_TypeError("arrays must be of the same type");
+    }
+    size_t itemsize = q == 15 ? sizeof(int16_t) : sizeof(int32_t);
+    size_t len = src.len / (3 * itemsize);
+    if(dst.len / itemsize < len) {
+        mp_raise_ValueError("out is too short");
+    }
+    if(q == 15) {
+        const int16_t *v = src.buf;
+        int16_t *lengths = dst.buf;
+        for(size_t i=0; i < len; i++, v += 3) {
+            lengths[i] = (int16_t)qvector_length_raw(v[0], v[1], v[2], 15);
+        }
+    } else {
+        const int32_t *v = src.buf;
+        int32_t *lengths = dst.buf;
+        for(size_t i=0; i < len; i++, v += 3) {
+            lengths[i] = qvector_length_raw(v[0], v[1], v[2], 31);
+        }
+    }
+    return out;
+}
+
+// qadd(a, b, out)
+//
+// The saturating element-wise sum of two Q15 ('h'), or Q31 ('i') arrays. out can be one of the operands.
+mp_obj_t vector_qadd(mp_obj_t a_in, mp_obj_t b_in, mp_obj_t out) {
+    mp_buffer_info_t a, b, dst;
+    mp_get_buffer_raise(a_in, &a, MP_BUFFER_READ);
+    mp_get_buffer_raise(b_in, &b, MP_BUFFER_READ);
+    mp_get_buffer_raise(out, &dst, MP_BUFFER_WRITE);
+    uint8_t q = qvector_buffer_format(&a);
+    if((b.typecode != a.typecode) || (dst.typecode != a.typecode)) {
+        mp_raise_TypeError("arrays must be of the same type");
+    }
+    if((b.len != a.len) || (dst.len < a.len)) {
+        mp_raise_ValueError("arrays must be of the same length");
+    }
+    if(q == 15) {
+        const int16_t *x = a.buf, *y = b.buf;
+        int16_t *sum = dst.buf;
+        for(size_t i=0; i < a.len / sizeof(int16_t); i++) {
+            sum[i] = (int16_t)qvector_saturate((int32_t)x[i] + y[i], 15);
+        }
+    } else {
+        const int32_t *x = a.buf, *y = b.buf;
+        int32_t *sum = dst.buf;
+        for(size_t i=0; i < a.len / sizeof(int32_t); i++) {
+            sum[i] = qvector_saturate((int64_t)x[i] + y[i], 31);
+        }
+    }
+    return out;
+}
@@ -2,5 +2,9 @@ USERMODULES_DIR := $(USERMOD_DIR)
 
 # Add all C files to SRC_USERMOD.
 SRC_USERMOD += $(USERMODULES_DIR)/vector.c
+SRC_USERMOD += $(USERMODULES_DIR)/vectorexpr.c
+SRC_USERMOD += $(USERMODULES_DIR)/transform.c
+SRC_USERMOD += $(USERMODULES_DIR)/fixedpoint.c
+SRC_USERMOD += $(USERMODULES_DIR)/fastmath.c
 
-CFLAGS_USERMOD += -I$(USERMODULES_DIR)
\ No newline at end of file
+CFLAGS_USERMOD += -I$(USERMODULES_DIR) -I$(USERMODULES_DIR)/../common -I$(USERMODULES_DIR)/../instrument
\ No newline at end of file
@@ -0,0 +1,405 @@
+/*
+ * This file is part of the micropython-usermod project, 
+ *
+ * https://github.com/v923z/micropython-usermod
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020 Zoltán Vörös
+*/
+    
+#include "py/obj.h"
+#include "py/runtime.h"
+#include "py/objlist.h"
+#include "vector.h"
+#include "pause.h"
+#include "instrument.h"
+
+// The kernels below are written out for the fixed sizes, without loops, so that the compiler
+// can keep everything in registers, and vectorise the batch loops
+
+static inline void transform_mat3_mul(float *out, const float *a, const float *b) {
+    out[0] = a[0]*b[0] + a[1]*b[3] + a[2]*b[6];
+    out[1] = a[0]*b[1] + a[1]*b[4] + a[2]*b[7];
+    out[2] = a[0]*b[2] + a[1]*b[5] + a[2]*b[8];
+    out[3] = a[3]*b[0] + a[4]*b[3] + a[5]*b[6];
+    out[4] = a[3]*b[1] + a[4]*b[4] + a[5]*b[7];
+    out[5] = a[3]*b[2] + a[4]*b[5] + a[5]*b[8];
+    out[6] = a[6]*b[0] + a[7]*b[3] + a[8]*b[6];
+    out[7] = a[6]*b[1] + a[7]*b[4] + a[8]*b[7];
+    out[8] = a[6]*b[2] + a[7]*b[5] + a[8]*b[8];
+}
+
+static inline void transform_mat3_apply(const float *m, float x, float y, float z, float *out) {
+    out[0] = m[0]*x + m[1]*y + m[2]*z;
+    out[1] = m[3]*x + m[4]*y + m[5]*z;
+    out[2] = m[6]*x + m[7]*y + m[8]*z;
+}
+
+// Hamilton product, the components are stored as w, x, y, z
+static inline void transform_quat_mul(float *out, const float *p, const float *q) {
+    out[0] = p[0]*q[0] - p[1]*q[1] - p[2]*q[2] - p[3]*q[3];
+    out[1] = p[0]*q[1] + p[1]*q[0] + p[2]*q[3] - p[3]*q[2];
+    out[2] = p[0]*q[2] - p[1]*q[3] + p[2]*q[0] + p[3]*q[1];
+    out[3] = p[0]*q[3] + p[1]*q[2] - p[2]*q[1] + p[3]*q[0];
+}
+
+// The rotation matrix of a quaternion. The quaternion need not be normalised,
+// the scaling is taken care of by dividing by its norm.
+static inline void transform_quat_to_mat3(const float *q, float *m) {
+    float w = q[0], x = q[1], y = q[2], z = q[3];
+    float n = w*w + x*x + y*y + z*z;
+    float s = n > 0.0f ? 2.0f / n : 0.0f;
+    m[0] = 1.0f - s*(y*y + z*z);
+    m[1] = s*(x*y - w*z);
+    m[2] = s*(x*z + w*y);
+    m[3] = s*(x*y + w*z);
+    m[4] = 1.0f - s*(x*x + z*z);
+    m[5] = s*(y*z - w*x);
+    m[6] = s*(x*z - w*y);
+    m[7] = s*(y*z + w*x);
+    m[8] = 1.0f - s*(x*x + y*y);
+}
+
+mp_obj_t create_new_mat3(const float *m) {
+    mat3_obj_t *self = m_new_obj(mat3_obj_t);
+    self->base.type = &mat3_type;
+    for(uint8_t i=0; i < 9; i++) {
+        self->m[i] = m[i];
+    }
+    return MP_OBJ_FROM_PTR(self);
+}
+
+mp_obj_t create_new_quat(const float *q) {
+    quat_obj_t *self = m_new_obj(quat_obj_t);
+    self->base.type = &quat_type;
+    self->q[0] = q[0];
+    self->q[1] = q[1];
+    self->q[2] = q[2];
+    self->q[3] = q[3];
+    return MP_OBJ_FROM_PTR(self);
+}
+
+// Returns the matrix of a mat3, or a quat, or raises TypeError
+STATIC void transform_get_matrix(mp_obj_t o_in, float *m) {
+    if(mp_obj_is_type(o_in, &mat3_type)) {
+        mat3_obj_t *mat = MP_OBJ_TO_PTR(o_in);
+        for(uint8_t i=0; i < 9; i++) {
+            m[i] = mat->m[i];
+        }
+    } else if(mp_obj_is_type(o_in, &quat_type)) {
+        quat_obj_t *quat = MP_OBJ_TO_PTR(o_in);
+        transform_quat_to_mat3(quat->q, m);
+    } else {
+        mp_raise_TypeError("transform must be a mat3, or a quat");
+    }
+}
+
+STATIC void transform_print_floats(const mp_print_t *print, const char *name, const float *f, size_t n) {
+    mp_print_str(print, name);
+    mp_print_str(print, "(");
+    for(size_t i=0; i < n; i++) {
+        mp_obj_print_helper(print, mp_obj_new_float(f[i]), PRINT_REPR);
+        if(i < n - 1) {
+            mp_print_str(print, ", ");
+        }
+    }
+    mp_print_str(print, ")");
+}
+
+STATIC void mat3_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t kind) {
+    (void)kind;
+    mat3_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    transform_print_floats(print, "mat3", self->m, 9);
+}
+
+// mat3() is the identity, mat3(m00, m01, ..., m22) takes the elements row by row, and
+// mat3(q) is the rotation matrix of the quaternion q
+STATIC mp_obj_t mat3_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    mp_arg_check_num(n_args, n_kw, 0, 9, true);
+    float m[9] = { 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f };
+    if(n_args == 1) {
+        transform_get_matrix(args[0], m);
+    } else if(n_args == 9) {
+        for(uint8_t i=0; i < 9; i++) {
+            m[i] = mp_obj_get_float(args[i]);
+        }
+    } else if(n_args != 0) {
+        mp_raise_TypeError("mat3 takes 0, 1, or 9 arguments");
+    }
+    return create_new_mat3(m);
+}
+
+STATIC mp_obj_t mat3_transpose(mp_obj_t self_in) {
+    mat3_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    const float *m = self->m;
+    float t[9] = { m[0], m[3], m[6], m[1], m[4], m[7], m[2], m[5], m[8] };
+    return create_new_mat3(t);
+}
+
+INSTRUMENT_WRAP_1(mat3_transpose)
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(mat3_transpose_obj, INSTRUMENT(mat3_transpose));
+
+STATIC mp_obj_t transform_binary_op(mp_binary_op_t op, mp_obj_t lhs, mp_obj_t rhs) {
+    if(op != MP_BINARY_OP_MULTIPLY) {
+        return MP_OBJ_NULL; // operator not supported
+    }
+    float out[9];
+    if(mp_obj_is_type(rhs, &vector_type) || mp_obj_is_type(rhs, &vector_expr_type)) {
+        float m[9];
+        transform_get_matrix(lhs, m);
+        vector_obj_t *vector = vector_get(rhs);
+        transform_mat3_apply(m, vector->x, vector->y, vector->z, out);
+        return create_new_vector(out[0], out[1], out[2]);
+    }
+    if(mp_obj_is_type(lhs, &quat_type) && mp_obj_is_type(rhs, &quat_type)) {
+        quat_obj_t *p = MP_OBJ_TO_PTR(lhs);
+        quat_obj_t *q = MP_OBJ_TO_PTR(rhs);
+        transform_quat_mul(out, p->q, q->q);
+        return create_new_quat(out);
+    }
+    if(mp_obj_is_type(rhs, &mat3_type) || mp_obj_is_type(rhs, &quat_type)) {
+        // a matrix and a rotation can be composed, the result is a matrix
+        float a[9], b[9];
+        transform_get_matrix(lhs, a);
+        transform_get_matrix(rhs, b);
+        transform_mat3_mul(out, a, b);
+        return create_new_mat3(out);
+    }
+    return MP_OBJ_NULL; // operator not supported
+}
+
+STATIC const mp_rom_map_elem_t mat3_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_transpose), MP_ROM_PTR(&mat3_transpose_obj) },
+};
+
+STATIC MP_DEFINE_CONST_DICT(mat3_locals_dict, mat3_locals_dict_table);
+
+INSTRUMENT_WRAP_BINARY_OP(transform_binary_op)
+
+const mp_obj_type_t mat3_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_mat3,
+    .print = mat3_print,
+    .make_new = mat3_make_new,
+    .binary_op = INSTRUMENT(transform_binary_op),
+    .locals_dict = (mp_obj_dict_t*)&mat3_locals_dict,
+};
+
+STATIC void quat_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t kind) {
+    (void)kind;
+    quat_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    transform_print_floats(print, "quat", self->q, 4);
+}
+
+STATIC mp_obj_t quat_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    mp_arg_check_num(n_args, n_kw, 4, 4, true);
+    float q[4];
+    for(uint8_t i=0; i < 4; i++) {
+        q[i] = mp_obj_get_float(args[i]);
+    }
+    return create_new_quat(q);
+}
+
+STATIC mp_obj_t quat_conjugate(mp_obj_t self_in) {
+    quat_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    float q[4] = { self->q[0], -self->q[1], -self->q[2], -self->q[3] };
+    return create_new_quat(q);
+}
+
+INSTRUMENT_WRAP_1(quat_conjugate)
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(quat_conjugate_obj, INSTRUMENT(quat_conjugate));
+
+STATIC const mp_rom_map_elem_t quat_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_conjugate), MP_ROM_PTR(&quat_conjugate_obj) },
+};
+
+STATIC MP_DEFINE_CONST_DICT(quat_locals_dict, quat_locals_dict_table);
+
+const mp_obj_type_t quat_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_quat,
+    .print = quat_print,
+    .make_new = quat_make_new,
+    .binary_op = INSTRUMENT(transform_binary_op),
+    .locals_dict = (mp_obj_dict_t*)&quat_locals_dict,
+};
+
+// The number of vectors that apply_async transforms, before it lets the other tasks run
+#ifndef VECTOR_APPLY_CHUNK
+#define VECTOR_APPLY_CHUNK (64)
+#endif
+
+// Transforms the vectors in [start, end), and returns the number of vectors. vectors is
+// a float array, which is transformed in place, or a sequence of vectors, whose results go
+// to out.
+STATIC size_t transform_apply_range(const float *m, mp_obj_t vectors, mp_obj_list_t *out, size_t start, size_t end) {
+    mp_buffer_info_t bufinfo;
+    if(mp_get_buffer(vectors, &bufinfo, MP_BUFFER_WRITE)) {
+        if(bufinfo.typecode != 'f') {
+            mp_raise_TypeError("array must be of type 'f'");
+        }
+        size_t len = bufinfo.len / (3 * sizeof(float));
+        end = end > len ? len : end;
+        float *v = (float *)bufinfo.buf + 3 * start;
+        for(size_t i=start; i < end; i++, v += 3) {
+            transform_mat3_apply(m, v[0], v[1], v[2], v);
+        }
+        return len;
+    }
+
+    size_t len;
+    mp_obj_t *items;
+    mp_obj_get_array(vectors, &len, &items);
+    // out was sized, when the task was created, and the sequence might have been
+    // resized by another task in the meantime
+    if(len != out->len) {
+        mp_raise_msg(&mp_type_RuntimeError, "vectors changed size during transform");
+    }
+    end = end > len ? len : end;
+    float rotated[3];
+    for(size_t i=start; i < end; i++) {
+        vector_obj_t *vector = vector_get(items[i]);
+        transform_mat3_apply(m, vector->x, vector->y, vector->z, rotated);
+        out->items[i] = create_new_vector(rotated[0], rotated[1], rotated[2]);
+    }
+    return len;
+}
+
+// Returns the list that holds the results of a sequence of vectors: a new one, or the
+// sequence itself with inplace. An array has no such list, and NULL is returned.
+STATIC mp_obj_list_t *transform_apply_out(mp_obj_t vectors, bool inplace) {
+    mp_buffer_info_t bufinfo;
+    if(mp_get_buffer(vectors, &bufinfo, MP_BUFFER_WRITE)) {
+        return NULL;
+    }
+    if(inplace) {
+        if(!mp_obj_is_type(vectors, &mp_type_list)) {
+            mp_raise_TypeError("only a list can be transformed in place");
+        }
+        return MP_OBJ_TO_PTR(vectors);
+    }
+    size_t len;
+    mp_obj_t *items;
+    mp_obj_get_array(vectors, &len, &items);
+    return MP_OBJ_TO_PTR(mp_obj_new_list(len, NULL));
+}
+
+// apply(transform, vectors, *, inplace=False)
+//
+// vectors is either a sequence of vectors, or a float array holding x, y, z triplets.
+// A sequence results in a new list, unless inplace is set. Then the items of the list are
+// replaced by new vectors, and the old vector objects are left untouched: a vector that
+// appears more than once, e.g., in [v]*n, is transformed once in each place, and an
+// expression keeps its value. An array is always transformed in place.
+mp_obj_t vector_apply(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_transform, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_rom_obj = MP_ROM_NONE } },
+        { MP_QSTR_vectors, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_rom_obj = MP_ROM_NONE } },
+        { MP_QSTR_inplace, MP_ARG_KW_ONLY | MP_ARG_BOOL, {.u_bool = false } },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    // a quaternion is turned into a matrix once, and not for each vector
+    float m[9];
+    transform_get_matrix(args[0].u_obj, m);
+    mp_obj_list_t *out = transform_apply_out(args[1].u_obj, args[2].u_bool);
+    transform_apply_range(m, args[1].u_obj, out, 0, SIZE_MAX);
+    return out == NULL ? args[1].u_obj : MP_OBJ_FROM_PTR(out);
+}
+
+// The state of an apply that is carried out in chunks. The object is its own iterator,
+// so that it can be awaited, and each step of the iteration transforms one chunk.
+typedef struct _transform_task_obj_t {
+    mp_obj_base_t base;
+    mp_obj_t vectors;
+    mp_obj_list_t *out;
+    mp_obj_t pause; // uasyncio.sleep_ms, or MP_OBJ_NULL, if uasyncio is not available
+    size_t chunk;
+    size_t pos;
+    bool done;
+    float m[9];
+} transform_task_obj_t;
+
+STATIC mp_obj_t transform_task_iternext(mp_obj_t self_in) {
+    transform_task_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if(self->done) {
+        return MP_OBJ_STOP_ITERATION;
+    }
+    size_t end = self->pos + self->chunk;
+    size_t len = transform_apply_range(self->m, self->vectors, self->out, self->pos, end);
+    self->pos = end;
+    if(self->pos >= len) {
+        self->done = true;
+        return MP_OBJ_STOP_ITERATION;
+    }
+    return pause_yield(self->pause);
+}
+
+INSTRUMENT_WRAP_1(transform_task_iternext)
+
+// Returns the transformed vectors of a finished task
+STATIC mp_obj_t transform_task_result(mp_obj_t self_in) {
+    transform_task_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if(!self->done) {
+        mp_raise_msg(&mp_type_RuntimeError, "transform is not finished");
+    }
+    return self->out == NULL ? self->vectors : MP_OBJ_FROM_PTR(self->out);
+}
+
+INSTRUMENT_WRAP_1(transform_task_result)
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(transform_task_result_obj, INSTRUMENT(transform_task_result));
+
+STATIC mp_obj_t transform_task_done(mp_obj_t self_in) {
+    transform_task_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    return mp_obj_new_bool(self->done);
+}
+
+INSTRUMENT_WRAP_1(transform_task_done)
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(transform_task_done_obj, INSTRUMENT(transform_task_done));
+
+STATIC const mp_rom_map_elem_t transform_task_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_result), MP_ROM_PTR(&transform_task_result_obj) },
+    { MP_ROM_QSTR(MP_QSTR_done), MP_ROM_PTR(&transform_task_done_obj) },
+};
+
+STATIC MP_DEFINE_CONST_DICT(transform_task_locals_dict, transform_task_locals_dict_table);
+
+const mp_obj_type_t transform_task_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_transformation,
+    .getiter = mp_identity_getiter,
+    .iternext = INSTRUMENT(transform_task_iternext),
+    .locals_dict = (mp_obj_dict_t*)&transform_task_locals_dict,
+};
+
+// apply_async(transform, vectors, *, inplace=False, chunk=VECTOR_APPLY_CHUNK)
+//
+// The same as apply, but the returned object has to be awaited in a uasyncio task, which
+// yields to the scheduler after each chunk. The result is available through the result method.
+// A sequence of vectors must not change its length, while the task is running.
+mp_obj_t vector_apply_async(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_transform, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_rom_obj = MP_ROM_NONE } },
+        { MP_QSTR_vectors, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_rom_obj = MP_ROM_NONE } },
+        { MP_QSTR_inplace, MP_ARG_KW_ONLY | MP_ARG_BOOL, {.u_bool = false } },
+        { MP_QSTR_chunk, MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = VECTOR_APPLY_CHUNK } },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    if(args[3].u_int < 1) {
+        mp_raise_ValueError("chunk must be positive");
+    }
+    transform_task_obj_t *self = m_new_obj(transform_task_obj_t);
+    self->base.type = &transform_task_type;
+    transform_get_matrix(args[0].u_obj, self->m);
+    self->vectors = args[1].u_obj;
+    self->out = transform_apply_out(args[1].u_obj, args[2].u_bool);
+    self->chunk = args[3].u_int;
+    self->pos = 0;
+    self->done = false;
+    self->pause = pause_get();
+    return MP_OBJ_FROM_PTR(self);
+}
@@ -10,25 +10,139 @@
     
 #include <math.h>
 #include <stdio.h>
+#include <string.h>
 #include "py/obj.h"
 #include "py/runtime.h"
+#include "py/binary.h"
+#include "py/objlist.h"
+#include "byteorder.h"
+#include "outarg.h"
+#include "vector.h"
+#include "instrument.h"
 
-const mp_obj_type_t vector_type;
+bool vector_lazy = false;
 
-typedef struct _vector_obj_t {
-    mp_obj_base_t base;
-    float x, y, z;
-} vector_obj_t;
+mp_obj_t create_new_vector(float x, float y, float z) {
+    vector_obj_t *vector = m_new_obj(vector_obj_t);
+    vector->base.type = &vector_type;
+    vector->x = x;
+    vector->y = y;
+    vector->z = z;
+    return MP_OBJ_FROM_PTR(vector);
+}
 
-STATIC mp_obj_t vector_length(mp_obj_t o_in) {
+// Returns the vector, or the value of an expression
+vector_obj_t *vector_get(mp_obj_t o_in) {
+    if(mp_obj_is_type(o_in, &vector_expr_type)) {
+        return vector_expr_eval(o_in);
+    }
     if(!mp_obj_is_type(o_in, &vector_type)) {
         mp_raise_TypeError("argument is not a vector");
     }
-    vector_obj_t *vector = MP_OBJ_TO_PTR(o_in);
-    return mp_obj_new_float(sqrtf(vector->x*vector->x + vector->y*vector->y + vector->z*vector->z));
+    return MP_OBJ_TO_PTR(o_in);
+}
+
+// The number of Newton steps for the fast keyword argument: the module setting, if the argument
+// is missing, exact for None, and the given number of steps otherwise
+STATIC int8_t vector_get_steps(mp_obj_t fast) {
+    if(fast == MP_OBJ_NULL) {
+        return vector_fastmath;
+    }
+    if(fast == mp_const_none) {
+        return VECTOR_FASTMATH_EXACT;
+    }
+    mp_int_t steps = mp_obj_get_int(fast);
+    if((steps < 0) || (steps > 3)) {
+        mp_raise_ValueError("the number of Newton steps must be between 0 and 3");
+    }
+    return (int8_t)steps;
+}
+
+// length(v, *, out=None, index=0, fast)
+//
+// With out, the result is written into out[index], and out is returned. fast selects the approximate
+// square root with the given number of Newton steps, or sqrtf with None; the default is set by fastmath.
+STATIC mp_obj_t vector_length(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_vector, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_rom_obj = MP_ROM_NONE } },
+        { MP_QSTR_out, MP_ARG_KW_ONLY | MP_ARG_OBJ, {.u_rom_obj = MP_ROM_NONE } },
+        { MP_QSTR_index, MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = 0 } },
+        { MP_QSTR_fast, MP_ARG_KW_ONLY | MP_ARG_OBJ, {.u_rom_obj = MP_ROM_NULL } },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    vector_obj_t *vector = vector_get(args[0].u_obj);
+    float length = vector_sqrt(vector->x*vector->x + vector->y*vector->y + vector->z*vector->z, vector_get_steps(args[3].u_obj));
+    if(args[1].u_obj != mp_const_none) {
+        outarg_store_float(args[1].u_obj, args[2].u_int, length);
+        return args[1].u_obj;
+    }
+    return mp_obj_new_float(length);
+}
+
+INSTRUMENT_WRAP_KW(vector_length)
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(vector_length_obj, 1, INSTRUMENT(vector_length));
+
+// normalize(v, *, fast)
+//
+// Returns the unit vector in the direction of v, or the null vector for the null vector
+STATIC mp_obj_t vector_normalize(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_vector, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_rom_obj = MP_ROM_NONE } },
+        { MP_QSTR_fast, MP_ARG_KW_ONLY | MP_ARG_OBJ, {.u_rom_obj = MP_ROM_NULL } },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    vector_obj_t *vector = vector_get(args[0].u_obj);
+    float norm2 = vector->x*vector->x + vector->y*vector->y + vector->z*vector->z;
+    if(norm2 == 0.0f) {
+        return create_new_vector(0.0f, 0.0f, 0.0f);
+    }
+    int8_t steps = vector_get_steps(args[1].u_obj);
+    float scale = steps == VECTOR_FASTMATH_EXACT ? 1.0f / sqrtf(norm2) : vector_fast_rsqrt(norm2, steps);
+    return create_new_vector(vector->x * scale, vector->y * scale, vector->z * scale);
+}
+
+INSTRUMENT_WRAP_KW(vector_normalize)
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(vector_normalize_obj, 1, INSTRUMENT(vector_normalize));
+
+// fastmath([steps]); sets the default of the fast keyword argument, and returns its current value
+STATIC mp_obj_t vector_set_fastmath(size_t n_args, const mp_obj_t *args) {
+    if(n_args == 1) {
+        vector_fastmath = vector_get_steps(args[0]);
+    }
+    if(vector_fastmath == VECTOR_FASTMATH_EXACT) {
+        return mp_const_none;
+    }
+    return MP_OBJ_NEW_SMALL_INT(vector_fastmath);
+}
+
+INSTRUMENT_WRAP_VAR(vector_set_fastmath)
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(vector_set_fastmath_obj, 0, 1, INSTRUMENT(vector_set_fastmath));
+
+// Table-driven approximations; see fastmath.c for their error bounds
+STATIC mp_obj_t vector_sin(mp_obj_t x) {
+    return mp_obj_new_float(vector_fast_sin(mp_obj_get_float(x)));
+}
+
+INSTRUMENT_WRAP_1(vector_sin)
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(vector_sin_obj, INSTRUMENT(vector_sin));
+
+STATIC mp_obj_t vector_cos(mp_obj_t x) {
+    return mp_obj_new_float(vector_fast_cos(mp_obj_get_float(x)));
 }
 
-STATIC MP_DEFINE_CONST_FUN_OBJ_1(vector_length_obj, vector_length);
+INSTRUMENT_WRAP_1(vector_cos)
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(vector_cos_obj, INSTRUMENT(vector_cos));
+
+STATIC mp_obj_t vector_atan2(mp_obj_t y, mp_obj_t x) {
+    return mp_obj_new_float(vector_fast_atan2(mp_obj_get_float(y), mp_obj_get_float(x)));
+}
+
+INSTRUMENT_WRAP_2(vector_atan2)
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(vector_atan2_obj, INSTRUMENT(vector_atan2));
 
 STATIC void vector_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t kind) {
     (void)kind;
@@ -44,26 +158,232 @@ STATIC void vector_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kin
 
 STATIC mp_obj_t vector_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
     mp_arg_check_num(n_args, n_kw, 3, 3, true);
-    
-    vector_obj_t *vector = m_new_obj(vector_obj_t);
-    vector->base.type = &vector_type;
-    vector->x = mp_obj_get_float(args[0]);
-    vector->y = mp_obj_get_float(args[1]);
-    vector->z = mp_obj_get_float(args[2]);
-    return MP_OBJ_FROM_PTR(vector);
+    return create_new_vector(mp_obj_get_float(args[0]), mp_obj_get_float(args[1]), mp_obj_get_float(args[2]));
 }
 
+STATIC mp_obj_t vector_subscr(mp_obj_t self_in, mp_obj_t index, mp_obj_t value) {
+    vector_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if (value != MP_OBJ_SENTINEL) { // the components can't be assigned to
+        return MP_OBJ_NULL;
+    }
+    switch (mp_obj_get_int(index)) {
+        case 0: case -3: return mp_obj_new_float(self->x);
+        case 1: case -2: return mp_obj_new_float(self->y);
+        case 2: case -1: return mp_obj_new_float(self->z);
+        default: mp_raise_msg(&mp_type_IndexError, "index is out of range");
+    }
+}
+
+STATIC mp_obj_t vector_binary_op(mp_binary_op_t op, mp_obj_t lhs, mp_obj_t rhs) {
+    if(op == MP_BINARY_OP_EQUAL) {
+        if(mp_obj_is_type(rhs, &vector_expr_type)) {
+            rhs = MP_OBJ_FROM_PTR(vector_expr_eval(rhs));
+        }
+    } else if(vector_lazy || mp_obj_is_type(rhs, &vector_expr_type)) {
+        return vector_expr_new(op, lhs, rhs);
+    }
+    vector_obj_t *a = MP_OBJ_TO_PTR(lhs);
+    float b[3];
+    if(mp_obj_is_type(rhs, &vector_type)) {
+        vector_obj_t *vector = MP_OBJ_TO_PTR(rhs);
+        b[0] = vector->x;
+        b[1] = vector->y;
+        b[2] = vector->z;
+    } else if(op == MP_BINARY_OP_ADD || op == MP_BINARY_OP_SUBTRACT || op == MP_BINARY_OP_MULTIPLY || op == MP_BINARY_OP_TRUE_DIVIDE) {
+        b[0] = b[1] = b[2] = mp_obj_get_float(rhs);
+    } else {
+        return MP_OBJ_NULL; // operator not supported
+    }
+    switch (op) {
+        case MP_BINARY_OP_EQUAL:
+            return mp_obj_new_bool((a->x == b[0]) && (a->y == b[1]) && (a->z == b[2]));
+        case MP_BINARY_OP_ADD:
+            return create_new_vector(a->x + b[0], a->y + b[1], a->z + b[2]);
+        case MP_BINARY_OP_SUBTRACT:
+            return create_new_vector(a->x - b[0], a->y - b[1], a->z - b[2]);
+        case MP_BINARY_OP_MULTIPLY:
+            return create_new_vector(a->x * b[0], a->y * b[1], a->z * b[2]);
+        case MP_BINARY_OP_TRUE_DIVIDE:
+            return create_new_vector(a->x / b[0], a->y / b[1], a->z / b[2]);
+        default:
+            return MP_OBJ_NULL; // operator not supported
+    }
+}
+
+// With lazy(True), the arithmetic operators return expressions that are evaluated in a single
+// pass, when eval() is called, or when an element is first accessed
+STATIC mp_obj_t vector_set_lazy(size_t n_args, const mp_obj_t *args) {
+    if(n_args == 1) {
+        vector_lazy = mp_obj_is_true(args[0]);
+    }
+    return mp_obj_new_bool(vector_lazy);
+}
+
+INSTRUMENT_WRAP_VAR(vector_set_lazy)
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(vector_set_lazy_obj, 0, 1, INSTRUMENT(vector_set_lazy));
+
+// Binary serialisation: a vector is packed as three IEEE 754 single-precision numbers
+#define VECTOR_PACKED_SIZE (3 * sizeof(uint32_t))
+
+STATIC void vector_pack(const vector_obj_t *vector, byte *dest, bool big_endian) {
+    union { float f; uint32_t u; } fp;
+    fp.f = vector->x;
+    mp_binary_set_int(sizeof(uint32_t), big_endian, dest, fp.u);
+    fp.f = vector->y;
+    mp_binary_set_int(sizeof(uint32_t), big_endian, dest + sizeof(uint32_t), fp.u);
+    fp.f = vector->z;
+    mp_binary_set_int(sizeof(uint32_t), big_endian, dest + 2 * sizeof(uint32_t), fp.u);
+}
+
+STATIC mp_obj_t vector_unpack(const byte *src, bool big_endian) {
+    union { float f; uint32_t u; } x, y, z;
+    x.u = mp_binary_get_int(sizeof(uint32_t), false, big_endian, src);
+    y.u = mp_binary_get_int(sizeof(uint32_t), false, big_endian, src + sizeof(uint32_t));
+    z.u = mp_binary_get_int(sizeof(uint32_t), false, big_endian, src + 2 * sizeof(uint32_t));
+    return create_new_vector(x.f, y.f, z.f);
+}
+
+STATIC mp_obj_t vector_to_bytes(size_t n_args, const mp_obj_t *args) {
+    bool big_endian = n_args > 1 ? byteorder_big_endian(args[1]) : false;
+    byte buffer[VECTOR_PACKED_SIZE];
+    vector_pack(vector_get(args[0]), buffer, big_endian);
+    return mp_obj_new_bytes(buffer, VECTOR_PACKED_SIZE);
+}
+
+INSTRUMENT_WRAP_VAR(vector_to_bytes)
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(vector_to_bytes_obj, 1, 2, INSTRUMENT(vector_to_bytes));
+
+// v.pack_into(buffer, offset=0, byteorder='little') writes a single vector, and returns the offset after it
+STATIC mp_obj_t vector_pack_into_method(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_buffer, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_rom_obj = MP_ROM_NONE } },
+        { MP_QSTR_offset, MP_ARG_INT, {.u_int = 0 } },
+        { MP_QSTR_byteorder, MP_ARG_OBJ, {.u_rom_obj = MP_ROM_QSTR(MP_QSTR_little) } },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+    byte *dest = byteorder_buffer_at(args[0].u_obj, args[1].u_int, VECTOR_PACKED_SIZE, MP_BUFFER_WRITE);
+    vector_pack(vector_get(pos_args[0]), dest, byteorder_big_endian(args[2].u_obj));
+    return mp_obj_new_int(args[1].u_int + VECTOR_PACKED_SIZE);
+}
+
+INSTRUMENT_WRAP_KW(vector_pack_into_method)
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(vector_pack_into_method_obj, 2, INSTRUMENT(vector_pack_into_method));
+
+// vector.pack_into(buffer, offset, vectors, byteorder='little') writes a whole sequence of vectors
+// back to back in a single call, and returns the offset after the last one
+STATIC mp_obj_t vector_pack_into(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_buffer, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_rom_obj = MP_ROM_NONE } },
+        { MP_QSTR_offset, MP_ARG_REQUIRED | MP_ARG_INT, {.u_int = 0 } },
+        { MP_QSTR_vectors, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_rom_obj = MP_ROM_NONE } },
+        { MP_QSTR_byteorder, MP_ARG_OBJ, {.u_rom_obj = MP_ROM_QSTR(MP_QSTR_little) } },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+    bool big_endian = byteorder_big_endian(args[3].u_obj);
+    size_t len = mp_obj_get_int(mp_obj_len(args[2].u_obj));
+    // the bounds are checked once for the whole sequence
+    byte *dest = byteorder_buffer_at(args[0].u_obj, args[1].u_int, len * VECTOR_PACKED_SIZE, MP_BUFFER_WRITE);
+    mp_obj_iter_buf_t iter_buf;
+    mp_obj_t item, iterable = mp_getiter(args[2].u_obj, &iter_buf);
+    for(size_t i=0; (i < len) && ((item = mp_iternext(iterable)) != MP_OBJ_STOP_ITERATION); i++) {
+        vector_pack(vector_get(item), dest, big_endian);
+        dest += VECTOR_PACKED_SIZE;
+    }
+    return mp_obj_new_int(args[1].u_int + len * VECTOR_PACKED_SIZE);
+}
+
+INSTRUMENT_WRAP_KW(vector_pack_into)
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(vector_pack_into_obj, 3, INSTRUMENT(vector_pack_into));
+
+STATIC mp_obj_t vector_from_bytes(size_t n_args, const mp_obj_t *args) {
+    bool big_endian = n_args > 1 ? byteorder_big_endian(args[1]) : false;
+    return vector_unpack(byteorder_buffer_at(args[0], 0, VECTOR_PACKED_SIZE, MP_BUFFER_READ), big_endian);
+}
+
+INSTRUMENT_WRAP_VAR(vector_from_bytes)
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(vector_from_bytes_obj, 1, 2, INSTRUMENT(vector_from_bytes));
+
+// vector.unpack_from(buffer, offset=0, count=1, byteorder='little') returns a list of count vectors
+STATIC mp_obj_t vector_unpack_from(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_buffer, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_rom_obj = MP_ROM_NONE } },
+        { MP_QSTR_offset, MP_ARG_INT, {.u_int = 0 } },
+        { MP_QSTR_count, MP_ARG_INT, {.u_int = 1 } },
+        { MP_QSTR_byteorder, MP_ARG_OBJ, {.u_rom_obj = MP_ROM_QSTR(MP_QSTR_little) } },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+    if(args[2].u_int < 0) {
+        mp_raise_ValueError("count must be non-negative");
+    }
+    size_t len = args[2].u_int;
+    bool big_endian = byteorder_big_endian(args[3].u_obj);
+    const byte *src = byteorder_buffer_at(args[0].u_obj, args[1].u_int, len * VECTOR_PACKED_SIZE, MP_BUFFER_READ);
+    mp_obj_list_t *list = MP_OBJ_TO_PTR(mp_obj_new_list(len, NULL));
+    for(size_t i=0; i < len; i++) {
+        list->items[i] = vector_unpack(src, big_endian);
+        src += VECTOR_PACKED_SIZE;
+    }
+    return MP_OBJ_FROM_PTR(list);
+}
+
+INSTRUMENT_WRAP_KW(vector_unpack_from)
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(vector_unpack_from_obj, 1, INSTRUMENT(vector_unpack_from));
+
+STATIC const mp_rom_map_elem_t vector_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_to_bytes), MP_ROM_PTR(&vector_to_bytes_obj) },
+    { MP_ROM_QSTR(MP_QSTR_pack_into), MP_ROM_PTR(&vector_pack_into_method_obj) },
+};
+
+STATIC MP_DEFINE_CONST_DICT(vector_locals_dict, vector_locals_dict_table);
+
+INSTRUMENT_WRAP_BINARY_OP(vector_binary_op)
+INSTRUMENT_WRAP_3(vector_subscr)
+
 const mp_obj_type_t vector_type = {
     { &mp_type_type },
     .name = MP_QSTR_vector,
     .print = vector_print,
     .make_new = vector_make_new,
+    .binary_op = INSTRUMENT(vector_binary_op),
+    .subscr = INSTRUMENT(vector_subscr),
+    .locals_dict = (mp_obj_dict_t*)&vector_locals_dict,
 };
 
+INSTRUMENT_WRAP_KW(vector_apply)
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(vector_apply_obj, 2, INSTRUMENT(vector_apply));
+INSTRUMENT_WRAP_KW(vector_apply_async)
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(vector_apply_async_obj, 2, INSTRUMENT(vector_apply_async));
+INSTRUMENT_WRAP_VAR(vector_fixed)
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(vector_fixed_obj, 1, 2, INSTRUMENT(vector_fixed));
+INSTRUMENT_WRAP_2(vector_qlengths)
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(vector_qlengths_obj, INSTRUMENT(vector_qlengths));
+INSTRUMENT_WRAP_3(vector_qadd)
+STATIC MP_DEFINE_CONST_FUN_OBJ_3(vector_qadd_obj, INSTRUMENT(vector_qadd));
+
 STATIC const mp_rom_map_elem_t vector_module_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_vector) },
     { MP_OBJ_NEW_QSTR(MP_QSTR_vector), (mp_obj_t)&vector_type },
     { MP_ROM_QSTR(MP_QSTR_length), MP_ROM_PTR(&vector_length_obj) },
+    { MP_ROM_QSTR(MP_QSTR_normalize), MP_ROM_PTR(&vector_normalize_obj) },
+    { MP_ROM_QSTR(MP_QSTR_fastmath), MP_ROM_PTR(&vector_set_fastmath_obj) },
+    { MP_ROM_QSTR(MP_QSTR_fast_sin), MP_ROM_PTR(&vector_sin_obj) },
+    { MP_ROM_QSTR(MP_QSTR_fast_cos), MP_ROM_PTR(&vector_cos_obj) },
+    { MP_ROM_QSTR(MP_QSTR_fast_atan2), MP_ROM_PTR(&vector_atan2_obj) },
+    { MP_ROM_QSTR(MP_QSTR_lazy), MP_ROM_PTR(&vector_set_lazy_obj) },
+    { MP_ROM_QSTR(MP_QSTR_pack_into), MP_ROM_PTR(&vector_pack_into_obj) },
+    { MP_ROM_QSTR(MP_QSTR_from_bytes), MP_ROM_PTR(&vector_from_bytes_obj) },
+    { MP_ROM_QSTR(MP_QSTR_unpack_from), MP_ROM_PTR(&vector_unpack_from_obj) },
+    { MP_ROM_QSTR(MP_QSTR_mat3), MP_ROM_PTR(&mat3_type) },
+    { MP_ROM_QSTR(MP_QSTR_quat), MP_ROM_PTR(&quat_type) },
+    { MP_ROM_QSTR(MP_QSTR_apply), MP_ROM_PTR(&vector_apply_obj) },
+    { MP_ROM_QSTR(MP_QSTR_apply_async), MP_ROM_PTR(&vector_apply_async_obj) },
+    { MP_ROM_QSTR(MP_QSTR_qvector), MP_ROM_PTR(&qvector_type) },
+    { MP_ROM_QSTR(MP_QSTR_fixed), MP_ROM_PTR(&vector_fixed_obj) },
+    { MP_ROM_QSTR(MP_QSTR_qlengths), MP_ROM_PTR(&vector_qlengths_obj) },
+    { MP_ROM_QSTR(MP_QSTR_qadd), MP_ROM_PTR(&vector_qadd_obj) },
 };
 STATIC MP_DEFINE_CONST_DICT(vector_module_globals, vector_module_globals_table);
 
@@ -0,0 +1,76 @@
+/*
+ * This file is part of the micropython-usermod project, 
+ *
+ * https://github.com/v923z/micropython-usermod
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020 Zoltán Vörös
+*/
+    
+#ifndef _VECTOR_H_
+#define _VECTOR_H_
+
+#include "py/obj.h"
+#include "py/runtime.h"
+
+typedef struct _vector_obj_t {
+    mp_obj_base_t base;
+    float x, y, z;
+} vector_obj_t;
+
+// A 3x3 matrix, with the elements stored row by row
+typedef struct _mat3_obj_t {
+    mp_obj_base_t base;
+    float m[9];
+} mat3_obj_t;
+
+// A quaternion, with the components stored in the order w, x, y, z
+typedef struct _quat_obj_t {
+    mp_obj_base_t base;
+    float q[4];
+} quat_obj_t;
+
+// A fixed-point vector, with q (15, or 31) fractional bits
+typedef struct _qvector_obj_t {
+    mp_obj_base_t base;
+    uint8_t q;
+    int32_t x, y, z;
+} qvector_obj_t;
+
+extern const mp_obj_type_t vector_type;
+extern const mp_obj_type_t vector_expr_type;
+extern const mp_obj_type_t mat3_type;
+extern const mp_obj_type_t quat_type;
+extern const mp_obj_type_t qvector_type;
+
+// true, if the arithmetic operators of vectors build expressions instead of computing the result
+extern bool vector_lazy;
+
+// The default number of Newton steps of the approximate square root; VECTOR_FASTMATH_EXACT stands for sqrtf
+#define VECTOR_FASTMATH_EXACT (-1)
+extern int8_t vector_fastmath;
+
+mp_obj_t create_new_vector(float , float , float );
+vector_obj_t *vector_get(mp_obj_t );
+
+mp_obj_t vector_expr_new(mp_binary_op_t , mp_obj_t , mp_obj_t );
+vector_obj_t *vector_expr_eval(mp_obj_t );
+
+mp_obj_t create_new_mat3(const float *);
+mp_obj_t create_new_quat(const float *);
+mp_obj_t vector_apply(size_t , const mp_obj_t *, mp_map_t *);
+mp_obj_t vector_apply_async(size_t , const mp_obj_t *, mp_map_t *);
+
+mp_obj_t create_new_qvector(int32_t , int32_t , int32_t , uint8_t );
+mp_obj_t vector_fixed(size_t , const mp_obj_t *);
+mp_obj_t vector_qlengths(mp_obj_t , mp_obj_t );
+mp_obj_t vector_qadd(mp_obj_t , mp_obj_t , mp_obj_t );
+
+float vector_fast_rsqrt(float , uint8_t );
+float vector_sqrt(float , int8_t );
+float vector_fast_sin(float );
+float vector_fast_cos(float );
+float vector_fast_atan2(float , float );
+
+#endif
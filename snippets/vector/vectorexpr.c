@@ -0,0 +1,224 @@
+/*
+ * This file is part of the micropython-usermod project, 
+ *
+ * https://github.com/v923z/micropython-usermod
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020 Zoltán Vörös
+*/
+    
+#include "py/obj.h"
+#include "py/runtime.h"
+#include "vector.h"
+#include "instrument.h"
+
+// The maximum number of vectors and scalars in a single expression. Longer
+// expressions are evaluated in parts, when they are being built.
+#ifndef VECTOR_EXPR_MAX_LEAVES
+#define VECTOR_EXPR_MAX_LEAVES (16)
+#endif
+
+// An expression node holds the operator and the two operands, each of which
+// is a vector, a number, or another expression node. Nothing is computed,
+// until the value is needed.
+typedef struct _vector_expr_obj_t {
+    mp_obj_base_t base;
+    mp_binary_op_t op;
+    uint8_t leaves;
+    mp_obj_t lhs;
+    mp_obj_t rhs;
+    vector_obj_t *value; // the result, once the expression has been evaluated
+} vector_expr_obj_t;
+
+enum {
+    VECTOR_EXPR_LOAD,
+    VECTOR_EXPR_ADD,
+    VECTOR_EXPR_SUBTRACT,
+    VECTOR_EXPR_MULTIPLY,
+    VECTOR_EXPR_DIVIDE,
+};
+
+typedef struct _vector_expr_instr_t {
+    uint8_t code;
+    float operand[3]; // the components of the vector, or the number broadcast, for VECTOR_EXPR_LOAD
+} vector_expr_instr_t;
+
+typedef struct _vector_expr_program_t {
+    size_t len;
+    vector_expr_instr_t instr[2*VECTOR_EXPR_MAX_LEAVES - 1];
+} vector_expr_program_t;
+
+STATIC uint8_t vector_expr_leaves(mp_obj_t o_in) {
+    if(mp_obj_is_type(o_in, &vector_expr_type)) {
+        vector_expr_obj_t *expr = MP_OBJ_TO_PTR(o_in);
+        return expr->value == NULL ? expr->leaves : 1;
+    }
+    return 1;
+}
+
+mp_obj_t vector_expr_new(mp_binary_op_t op, mp_obj_t lhs, mp_obj_t rhs) {
+    switch (op) {
+        case MP_BINARY_OP_ADD:
+        case MP_BINARY_OP_SUBTRACT:
+        case MP_BINARY_OP_MULTIPLY:
+        case MP_BINARY_OP_TRUE_DIVIDE:
+            break;
+        default:
+            return MP_OBJ_NULL; // operator not supported
+    }
+    // the operands are checked here, so that the errors show up where the expression is written
+    if(!mp_obj_is_type(rhs, &vector_type) && !mp_obj_is_type(rhs, &vector_expr_type)) {
+        mp_obj_get_float(rhs);
+    }
+    // keep the program within bounds by evaluating the longer branch first,
+    // and the other one, too, if the two together are still too long
+    if(vector_expr_leaves(lhs) + vector_expr_leaves(rhs) > VECTOR_EXPR_MAX_LEAVES) {
+        if(vector_expr_leaves(lhs) >= vector_expr_leaves(rhs)) {
+            lhs = MP_OBJ_FROM_PTR(vector_expr_eval(lhs));
+        } else {
+            rhs = MP_OBJ_FROM_PTR(vector_expr_eval(rhs));
+        }
+    }
+    if(vector_expr_leaves(lhs) + vector_expr_leaves(rhs) > VECTOR_EXPR_MAX_LEAVES) {
+        if(mp_obj_is_type(lhs, &vector_expr_type)) {
+            lhs = MP_OBJ_FROM_PTR(vector_expr_eval(lhs));
+        }
+        if(mp_obj_is_type(rhs, &vector_expr_type)) {
+            rhs = MP_OBJ_FROM_PTR(vector_expr_eval(rhs));
+        }
+    }
+    vector_expr_obj_t *expr = m_new_obj(vector_expr_obj_t);
+    expr->base.type = &vector_expr_type;
+    expr->op = op;
+    expr->leaves = vector_expr_leaves(lhs) + vector_expr_leaves(rhs);
+    expr->lhs = lhs;
+    expr->rhs = rhs;
+    expr->value = NULL;
+    return MP_OBJ_FROM_PTR(expr);
+}
+
+// Flattens the tree into postfix order
+STATIC void vector_expr_compile(mp_obj_t o_in, vector_expr_program_t *program) {
+    vector_expr_instr_t *instr;
+    if(mp_obj_is_type(o_in, &vector_expr_type)) {
+        vector_expr_obj_t *expr = MP_OBJ_TO_PTR(o_in);
+        if(expr->value == NULL) {
+            vector_expr_compile(expr->lhs, program);
+            vector_expr_compile(expr->rhs, program);
+            assert(program->len < 2*VECTOR_EXPR_MAX_LEAVES - 1);
+            instr = &program->instr[program->len++];
+            switch (expr->op) {
+                case MP_BINARY_OP_ADD: instr->code = VECTOR_EXPR_ADD; break;
+                case MP_BINARY_OP_SUBTRACT: instr->code = VECTOR_EXPR_SUBTRACT; break;
+                case MP_BINARY_OP_MULTIPLY: instr->code = VECTOR_EXPR_MULTIPLY; break;
+                default: instr->code = VECTOR_EXPR_DIVIDE; break;
+            }
+            return;
+        }
+        // a sub-expression that has already been evaluated is just a vector
+        o_in = MP_OBJ_FROM_PTR(expr->value);
+    }
+    assert(program->len < 2*VECTOR_EXPR_MAX_LEAVES - 1);
+    instr = &program->instr[program->len++];
+    instr->code = VECTOR_EXPR_LOAD;
+    if(mp_obj_is_type(o_in, &vector_type)) {
+        vector_obj_t *vector = MP_OBJ_TO_PTR(o_in);
+        instr->operand[0] = vector->x;
+        instr->operand[1] = vector->y;
+        instr->operand[2] = vector->z;
+    } else {
+        instr->operand[0] = instr->operand[1] = instr->operand[2] = mp_obj_get_float(o_in);
+    }
+}
+
+// Runs the program in a single pass, all three components at a time. The
+// intermediate results live on the C stack, and only the result is allocated.
+STATIC mp_obj_t vector_expr_run(vector_expr_program_t *program) {
+    float stack[VECTOR_EXPR_MAX_LEAVES][3];
+    size_t sp = 0;
+    for(size_t i=0; i < program->len; i++) {
+        vector_expr_instr_t *instr = &program->instr[i];
+        if(instr->code == VECTOR_EXPR_LOAD) {
+            assert(sp < VECTOR_EXPR_MAX_LEAVES);
+            stack[sp][0] = instr->operand[0];
+            stack[sp][1] = instr->operand[1];
+            stack[sp][2] = instr->operand[2];
+            sp++;
+            continue;
+        }
+        assert(sp >= 2);
+        float *a = stack[sp-2];
+        float *b = stack[sp-1];
+        switch (instr->code) {
+            case VECTOR_EXPR_ADD:
+                a[0] += b[0]; a[1] += b[1]; a[2] += b[2];
+                break;
+            case VECTOR_EXPR_SUBTRACT:
+                a[0] -= b[0]; a[1] -= b[1]; a[2] -= b[2];
+                break;
+            case VECTOR_EXPR_MULTIPLY:
+                a[0] *= b[0]; a[1] *= b[1]; a[2] *= b[2];
+                break;
+            default:
+                a[0] /= b[0]; a[1] /= b[1]; a[2] /= b[2];
+                break;
+        }
+        sp--;
+    }
+    return create_new_vector(stack[0][0], stack[0][1], stack[0][2]);
+}
+
+vector_obj_t *vector_expr_eval(mp_obj_t o_in) {
+    vector_expr_obj_t *expr = MP_OBJ_TO_PTR(o_in);
+    if(expr->value == NULL) {
+        vector_expr_program_t program;
+        program.len = 0;
+        vector_expr_compile(o_in, &program);
+        expr->value = MP_OBJ_TO_PTR(vector_expr_run(&program));
+        // the operands are no longer needed, let the garbage collector have them
+        expr->lhs = expr->rhs = mp_const_none;
+    }
+    return expr->value;
+}
+
+STATIC mp_obj_t vector_expr_eval_method(mp_obj_t self_in) {
+    return MP_OBJ_FROM_PTR(vector_expr_eval(self_in));
+}
+
+INSTRUMENT_WRAP_1(vector_expr_eval_method)
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(vector_expr_eval_obj, INSTRUMENT(vector_expr_eval_method));
+
+STATIC void vector_expr_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t kind) {
+    mp_obj_print_helper(print, MP_OBJ_FROM_PTR(vector_expr_eval(self_in)), kind);
+}
+
+STATIC mp_obj_t vector_expr_binary_op(mp_binary_op_t op, mp_obj_t lhs, mp_obj_t rhs) {
+    if(op == MP_BINARY_OP_EQUAL) {
+        return mp_binary_op(op, MP_OBJ_FROM_PTR(vector_expr_eval(lhs)), rhs);
+    }
+    return vector_expr_new(op, lhs, rhs);
+}
+
+// The first access to an element evaluates the expression
+STATIC mp_obj_t vector_expr_subscr(mp_obj_t self_in, mp_obj_t index, mp_obj_t value) {
+    return mp_obj_subscr(MP_OBJ_FROM_PTR(vector_expr_eval(self_in)), index, value);
+}
+
+STATIC const mp_rom_map_elem_t vector_expr_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_eval), MP_ROM_PTR(&vector_expr_eval_obj) },
+};
+
+STATIC MP_DEFINE_CONST_DICT(vector_expr_locals_dict, vector_expr_locals_dict_table);
+
+INSTRUMENT_WRAP_BINARY_OP(vector_expr_binary_op)
+INSTRUMENT_WRAP_3(vector_expr_subscr)
+
+const mp_obj_type_t vector_expr_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_expression,
+    .print = vector_expr_print,
+    .binary_op = INSTRUMENT(vector_expr_binary_op),
+    .subscr = INSTRUMENT(vector_expr_subscr),
+    .locals_dict = (mp_obj_dict_t*)&vector_expr_locals_dict,
+};